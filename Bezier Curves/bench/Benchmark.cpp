@@ -0,0 +1,822 @@
+//headless benchmark of the curve math, no GL needed
+//usage: bezier_bench [--quick] [--out results.json] [--baseline old.json] [--tolerance 0.15]
+
+#include "../include/BezierCurve.h"
+#include "../include/BezierCurveN.h"
+#include "../include/BezierBatch.h"
+#include "../include/CompositeCurve.h"
+#include "../include/CurveScene.h"
+#include "../include/CurveQuery.h"
+#include "../include/ThreadPool.h"
+#include "../include/CountingResource.h"
+#include "../include/SpatialGrid.h"
+#include "../include/BoundingBox.h"
+#include "../include/Profiler.h"
+#include "../include/SceneFile.h"
+#include "../include/TessellationThread.h"
+#include "../include/EditScript.h"
+#include "../include/PngWriter.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+#ifdef _MSC_VER
+#include <malloc.h>
+#endif
+
+namespace {
+	std::atomic<size_t> allocationCount{0};
+}
+
+//every replaced operator new has its own matching delete, the aligned forms go through the platform's aligned allocator
+//because free() can't release what _aligned_malloc returned
+namespace {
+	void* countedAlloc(const size_t size) {
+		allocationCount.fetch_add(1,std::memory_order_relaxed);
+		if(void* p = std::malloc(size ? size : 1)) {
+			return p;
+		}
+		throw std::bad_alloc();
+	}
+	void* countedAlignedAlloc(const size_t size, const std::align_val_t alignment) {
+		allocationCount.fetch_add(1,std::memory_order_relaxed);
+		const size_t align = static_cast<size_t>(alignment);
+		//aligned_alloc wants a size that is a multiple of the alignment
+		const size_t rounded = (std::max<size_t>(size,1)+align-1)/align*align;
+#ifdef _MSC_VER
+		void* p = _aligned_malloc(rounded,align);
+#else
+		void* p = std::aligned_alloc(align,rounded);
+#endif
+		if(p) {
+			return p;
+		}
+		throw std::bad_alloc();
+	}
+	void alignedFree(void* p) {
+#ifdef _MSC_VER
+		_aligned_free(p);
+#else
+		std::free(p);
+#endif
+	}
+}
+
+void* operator new(const size_t size) {
+	return countedAlloc(size);
+}
+void* operator new[](const size_t size) {
+	return countedAlloc(size);
+}
+void operator delete(void* p) noexcept {
+	std::free(p);
+}
+void operator delete[](void* p) noexcept {
+	std::free(p);
+}
+void operator delete(void* p, size_t) noexcept {
+	std::free(p);
+}
+void operator delete[](void* p, size_t) noexcept {
+	std::free(p);
+}
+void* operator new(const size_t size, const std::align_val_t alignment) {
+	return countedAlignedAlloc(size,alignment);
+}
+void* operator new[](const size_t size, const std::align_val_t alignment) {
+	return countedAlignedAlloc(size,alignment);
+}
+void operator delete(void* p, std::align_val_t) noexcept {
+	alignedFree(p);
+}
+void operator delete[](void* p, std::align_val_t) noexcept {
+	alignedFree(p);
+}
+void operator delete(void* p, size_t, std::align_val_t) noexcept {
+	alignedFree(p);
+}
+void operator delete[](void* p, size_t, std::align_val_t) noexcept {
+	alignedFree(p);
+}
+
+namespace {
+	struct Result {
+		std::string name;
+		size_t points = 0;
+		float precision = 0.0f;
+		size_t samplesPerCall = 0;
+		size_t iterations = 0;
+		double nsPerCall = 0.0;
+		double nsPerSample = 0.0;
+		double allocationsPerCall = 0.0;
+		double megaSamplesPerSecond = 0.0;
+	};
+
+	struct Options {
+		bool quick = false;
+		std::string out;
+		std::string baseline;
+		double tolerance = 0.15;
+		double minSeconds = 0.05;
+	};
+
+	//zig-zag control polygon in the 800x600 window, deterministic across runs
+	void fillPoints(std::vector<glm::vec2>& points, const size_t count) {
+		points.clear();
+		for(size_t i=0;i<count;i++) {
+			const float x = 20.0f+760.0f*static_cast<float>(i)/static_cast<float>(count>1 ? count-1 : 1);
+			const float y = 300.0f+250.0f*((i*7919)%17/8.0f-1.0f);
+			points.push_back({x,y});
+		}
+	}
+	void fillCurve(BezierCurve& curve, const size_t count) {
+		std::vector<glm::vec2> points;
+		fillPoints(points,count);
+		curve.ClearPoints();
+		for(const glm::vec2 point : points) {
+			curve.AddPoint(point);
+		}
+	}
+
+	//one warm-up call, then repeats until minSeconds passed
+	Result measure(const Options& options, const std::string& name, const size_t points, const float precision, const std::function<size_t()>& call) {
+		Result result;
+		result.name = name;
+		result.points = points;
+		result.precision = precision;
+		call();
+		const size_t allocationsBefore = allocationCount.load();
+		size_t samples = 0;
+		const auto start = std::chrono::steady_clock::now();
+		double elapsed = 0.0;
+		do {
+			samples += call();
+			result.iterations++;
+			elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+		} while(elapsed<options.minSeconds);
+		const size_t allocations = allocationCount.load()-allocationsBefore;
+		result.samplesPerCall = samples/result.iterations;
+		result.nsPerCall = elapsed*1e9/result.iterations;
+		result.nsPerSample = samples>0 ? elapsed*1e9/samples : 0.0;
+		result.allocationsPerCall = static_cast<double>(allocations)/result.iterations;
+		result.megaSamplesPerSecond = samples/elapsed/1e6;
+		return result;
+	}
+
+	std::string key(const Result& r) {
+		std::ostringstream s;
+		s << r.name << "/" << r.points << "/" << r.precision;
+		return s.str();
+	}
+
+	void writeJson(std::ostream& out, const std::vector<Result>& results) {
+		out << "{\n  \"isa\": \"" << BezierBatch::Name(BezierBatch::Detect()) << "\",\n  \"results\": [\n";
+		for(size_t i=0;i<results.size();i++) {
+			const Result& r = results[i];
+			out << "    {\"key\": \"" << key(r) << "\", \"name\": \"" << r.name << "\", \"points\": " << r.points
+				<< ", \"precision\": " << r.precision << ", \"samples_per_call\": " << r.samplesPerCall
+				<< ", \"iterations\": " << r.iterations << ", \"ns_per_call\": " << r.nsPerCall
+				<< ", \"ns_per_sample\": " << r.nsPerSample << ", \"allocations_per_call\": " << r.allocationsPerCall
+				<< ", \"msamples_per_second\": " << r.megaSamplesPerSecond << "}" << (i+1<results.size() ? "," : "") << "\n";
+		}
+		out << "  ]\n}\n";
+	}
+
+	//reads back what writeJson produced, one result per line
+	std::map<std::string,double> readBaseline(const std::string& path) {
+		std::map<std::string,double> baseline;
+		std::ifstream file(path);
+		std::string line;
+		while(std::getline(file,line)) {
+			const size_t keyPos = line.find("\"key\": \"");
+			const size_t nsPos = line.find("\"ns_per_call\": ");
+			if(keyPos==std::string::npos || nsPos==std::string::npos) {
+				continue;
+			}
+			const size_t keyStart = keyPos+8;
+			const std::string k = line.substr(keyStart,line.find('"',keyStart)-keyStart);
+			baseline[k] = std::atof(line.c_str()+nsPos+15);
+		}
+		return baseline;
+	}
+
+	void runCurveBenchmarks(const Options& options, std::vector<Result>& results) {
+		const std::vector<size_t> pointCounts = options.quick ? std::vector<size_t>{4,64,1024} : std::vector<size_t>{4,8,16,32,64,128,256,512,1024};
+		const std::vector<float> precisions = options.quick ? std::vector<float>{0.01f,0.001f} : std::vector<float>{0.1f,0.01f,0.001f,0.0001f};
+		using Mode = BezierCurve::EvaluationMode;
+		const std::pair<Mode,const char*> modes[] = {
+			{Mode::DeCasteljau,"recalculate_de_casteljau"},
+			{Mode::Bernstein,"recalculate_bernstein"},
+			{Mode::ForwardDifference,"recalculate_forward_difference"}
+		};
+		for(const size_t count : pointCounts) {
+			for(const float precision : precisions) {
+				BezierCurve curve;
+				fillCurve(curve,count);
+				curve.SetPrecision(precision);
+				for(const auto& mode : modes) {
+					//the reference is O(n^2) per sample, skip what would take seconds per call
+					if(mode.first==Mode::DeCasteljau && static_cast<double>(count)*count*curve.SampleCount()>2e9) {
+						continue;
+					}
+					curve.SetEvaluationMode(mode.first);
+					//long curves fall back to another mode, which has its own row
+					if(curve.EffectiveEvaluationMode()!=mode.first) {
+						continue;
+					}
+					results.push_back(measure(options,mode.second,count,precision,[&] {
+						curve.RecalculateLine();
+						return curve.linePoints.size();
+					}));
+				}
+				curve.SetEvaluationMode(Mode::Bernstein);
+				const BezierBatch::InstructionSet detected = BezierBatch::Detect();
+				//the batches only run the bernstein path
+				const int lastSet = curve.EffectiveEvaluationMode()==Mode::Bernstein ? static_cast<int>(detected) : -1;
+				for(int set=0;set<=lastSet;set++) {
+					BezierBatch::SetActive(static_cast<BezierBatch::InstructionSet>(set));
+					results.push_back(measure(options,std::string("batch_")+BezierBatch::Name(BezierBatch::Active()),count,precision,[&] {
+						curve.RecalculateLine();
+						return curve.linePoints.size();
+					}));
+				}
+				BezierBatch::SetActive(detected);
+
+				curve.RecalculateLine();
+				size_t frame = 0;
+				results.push_back(measure(options,"move_point_incremental",count,precision,[&] {
+					const size_t index = count/2;
+					const glm::vec2 pos = curve.Points()[index]+glm::vec2((frame++%2) ? 1.0f : -1.0f,0.0f);
+					return curve.MovePoint(index,pos).count;
+				}));
+
+				curve.SetTessellationMode(BezierCurve::TessellationMode::Adaptive);
+				results.push_back(measure(options,"recalculate_adaptive",count,precision,[&] {
+					curve.RecalculateLine();
+					return curve.linePoints.size();
+				}));
+			}
+		}
+	}
+
+	//the compile time degree against the dynamic curve with the same points
+	template<size_t Degree>
+	void runFixedDegreeBenchmark(const Options& options, std::vector<Result>& results, const float precision) {
+		std::vector<glm::vec2> points;
+		fillPoints(points,Degree+1);
+		std::array<glm::vec2,Degree+1> fixedPoints;
+		std::copy(points.begin(),points.end(),fixedPoints.begin());
+		BezierCurveN<Degree> fixed(fixedPoints);
+		fixed.SetPrecision(precision);
+		std::vector<glm::vec2> fixedLine(fixed.SampleCount());
+		results.push_back(measure(options,"fixed_degree_recalculate",Degree+1,precision,[&] {
+			fixed.RecalculateLine(fixedLine.data());
+			return fixedLine.size();
+		}));
+		BezierCurve curve;
+		fillCurve(curve,Degree+1);
+		curve.SetPrecision(precision);
+		curve.SetEvaluationMode(BezierCurve::EvaluationMode::Bernstein);
+		results.push_back(measure(options,"dynamic_degree_recalculate",Degree+1,precision,[&] {
+			curve.RecalculateLine();
+			return curve.linePoints.size();
+		}));
+	}
+
+	void runFixedDegreeBenchmarks(const Options& options, std::vector<Result>& results) {
+		const float precision = 0.001f;
+		runFixedDegreeBenchmark<2>(options,results,precision);
+		runFixedDegreeBenchmark<3>(options,results,precision);
+		runFixedDegreeBenchmark<5>(options,results,precision);
+	}
+
+	//the same uniform tessellation in every scalar backend, and what error tracking adds on top
+	void runBackendBenchmarks(const Options& options, std::vector<Result>& results) {
+		const std::vector<size_t> pointCounts = options.quick ? std::vector<size_t>{4,64} : std::vector<size_t>{4,16,64,256};
+		const float precision = 0.001f;
+		using Backend = BezierCurve::ScalarBackend;
+		const std::pair<Backend,const char*> backends[] = {
+			{Backend::Float,"backend_float"},
+			{Backend::Double,"backend_double"},
+			{Backend::Fixed,"backend_fixed"}
+		};
+		for(const size_t count : pointCounts) {
+			BezierCurve curve;
+			fillCurve(curve,count);
+			curve.SetPrecision(precision);
+			for(const auto& backend : backends) {
+				curve.SetScalarBackend(backend.first);
+				results.push_back(measure(options,backend.second,count,precision,[&] {
+					curve.RecalculateLine();
+					return curve.linePoints.size();
+				}));
+			}
+			curve.SetScalarBackend(Backend::Float);
+			curve.SetErrorTracking(true);
+			results.push_back(measure(options,"backend_error_tracking",count,precision,[&] {
+				curve.RecalculateLine();
+				return curve.linePoints.size();
+			}));
+		}
+	}
+
+	void runCompositeBenchmarks(const Options& options, std::vector<Result>& results) {
+		const std::vector<size_t> pointCounts = options.quick ? std::vector<size_t>{64,4096} : std::vector<size_t>{64,1024,16384,262144};
+		for(const size_t count : pointCounts) {
+			CompositeCurve curve;
+			std::vector<glm::vec2> points;
+			fillPoints(points,count);
+			curve.points.assign(points.begin(),points.end());
+			curve.RecalculateLine();
+			size_t frame = 0;
+			results.push_back(measure(options,"composite_move_point",count,curve.GetPrecision(),[&] {
+				const size_t index = count/2;
+				const glm::vec2 pos = curve.points[index]+glm::vec2((frame++%2) ? 1.0f : -1.0f,0.0f);
+				return curve.MovePoint(index,pos).count;
+			}));
+			results.push_back(measure(options,"composite_recalculate",count,curve.GetPrecision(),[&] {
+				curve.RecalculateLine();
+				return curve.linePoints.size();
+			}));
+		}
+	}
+
+	void runSceneBenchmarks(const Options& options, std::vector<Result>& results) {
+		ThreadPool pool;
+		const std::vector<size_t> curveCounts = options.quick ? std::vector<size_t>{1000} : std::vector<size_t>{100,1000,10000};
+		for(const size_t curves : curveCounts) {
+			CurveScene scene;
+			for(size_t i=0;i<curves;i++) {
+				fillCurve(scene.curves[scene.AddCurve()],4+i%12);
+			}
+			results.push_back(measure(options,"scene_tessellate_all",curves,0.01f,[&] {
+				scene.MarkAllDirty();
+				scene.BeginTessellation(pool);
+				scene.FinishTessellation(pool);
+				return scene.Vertices().size();
+			}));
+		}
+
+		//dragging and zooming back and forth, once the buffers have grown this must not allocate at all
+		CountingResource counting;
+		CurveScene scene(&counting);
+		for(size_t i=0;i<100;i++) {
+			fillCurve(scene.curves[scene.AddCurve()],4+i%12);
+		}
+		size_t frame = 0;
+		const auto edit = [&] {
+			const size_t c = frame%scene.curves.size();
+			const glm::vec2 pos = scene.curves[c].Points()[1]+glm::vec2((frame++%2) ? 1.0f : -1.0f,0.0f);
+			size_t samples = scene.MovePoint(c,1,pos).lines.count;
+			for(const float precision : {0.005f,0.01f}) {
+				for(BezierCurve& curve : scene.curves) {
+					curve.SetPrecision(precision);
+				}
+				scene.MarkAllDirty();
+				scene.BeginTessellation(pool);
+				scene.FinishTessellation(pool);
+				samples += scene.Vertices().size();
+			}
+			return samples;
+		};
+		//the first move of a curve builds its basis cache, so every curve gets one before counting
+		scene.BeginTessellation(pool);
+		scene.FinishTessellation(pool);
+		for(size_t i=0;i<scene.curves.size();i++) {
+			edit();
+		}
+		counting.Reset();
+		results.push_back(measure(options,"scene_edit_steady_state",scene.curves.size(),0.01f,edit));
+		//allocations_per_call comes from the global counter like everywhere else, the scene's own resource also covers
+		//the warm-up call and says whether the scene's buffers are the ones that grew
+		if(counting.Allocations()>0) {
+			std::cout << "scene_edit_steady_state: " << counting.Allocations() << " allocations from the scene resource, "
+				<< counting.BytesAllocated() << " bytes" << std::endl;
+		}
+	}
+
+	//what a frame pays for a drag with the tessellation on its own thread, against waiting for the edit to come back tessellated
+	void runAsyncBenchmarks(const Options& options, std::vector<Result>& results) {
+		ThreadPool pool;
+		const std::vector<size_t> pointCounts = options.quick ? std::vector<size_t>{4,1024} : std::vector<size_t>{4,64,256,1024};
+		for(const size_t count : pointCounts) {
+			TessellationThread tessellator(pool);
+			tessellator.Start();
+			BezierCurve curve;
+			fillCurve(curve,count);
+			curve.SetPrecision(0.001f);
+			size_t frame = 0;
+			const auto drag = [&] {
+				const glm::vec2 pos = curve.Points()[count/2]+glm::vec2((frame++%2) ? 1.0f : -1.0f,0.0f);
+				curve.SetPoint(count/2,pos);
+				tessellator.SubmitCurve(0,curve);
+			};
+			results.push_back(measure(options,"async_submit",count,0.001f,[&] {
+				drag();
+				tessellator.Acquire();
+				return size_t(1);
+			}));
+			results.push_back(measure(options,"async_round_trip",count,0.001f,[&] {
+				drag();
+				tessellator.Flush();
+				tessellator.Acquire();
+				return tessellator.Current()->vertices.size();
+			}));
+			//the same drag as a moved point, which the worker applies incrementally
+			results.push_back(measure(options,"async_move_round_trip",count,0.001f,[&] {
+				const glm::vec2 pos = curve.Points()[count/2]+glm::vec2((frame++%2) ? 1.0f : -1.0f,0.0f);
+				curve.SetPoint(count/2,pos);
+				tessellator.SubmitMovePoint(0,count/2,pos);
+				tessellator.Flush();
+				tessellator.Acquire();
+				return tessellator.Current()->vertices.size();
+			}));
+		}
+	}
+
+	//the cpu side of a headless frame playing the synthetic script, and a frame written as png for golden images
+	//the script is played without inserts, which would make every pass over it slower than the one before
+	void runHeadlessBenchmarks(const Options& options, std::vector<Result>& results) {
+		ThreadPool pool;
+		CurveScene scene;
+		const size_t curves = 16;
+		const size_t count = 16;
+		for(size_t i=0;i<curves;i++) {
+			fillCurve(scene.curves[scene.AddCurve()],count);
+		}
+		scene.SetView({glm::vec2(-1e6f),glm::vec2(1e6f)});
+		scene.BeginTessellation(pool);
+		scene.FinishTessellation(pool);
+		const EditScript script = EditScript::Synthetic(600,0);
+		size_t frame = 0;
+		results.push_back(measure(options,"headless_script_frame",count,0.01f,[&] {
+			const EditScript::Step& step = script.Frame(frame++%script.FrameCount());
+			const size_t c = step.curve%curves;
+			if(step.kind==EditScript::Kind::Drag) {
+				const size_t index = step.point%count;
+				scene.MovePoint(c,index,scene.curves[c].Points()[index]+step.value);
+			}else if(step.kind==EditScript::Kind::Precision) {
+				for(BezierCurve& curve : scene.curves) {
+					curve.SetPrecision(curve.GetPrecision()*step.factor);
+				}
+				scene.MarkAllDirty();
+			}
+			scene.BeginTessellation(pool);
+			scene.FinishTessellation(pool);
+			scene.Cull();
+			return scene.Vertices().size();
+		}));
+
+		const uint32_t width = 800;
+		const uint32_t height = 600;
+		std::vector<uint8_t> pixels(static_cast<size_t>(width)*height*4);
+		for(size_t i=0;i<pixels.size();i++) {
+			pixels[i] = static_cast<uint8_t>(i*2654435761u>>24);
+		}
+		const std::string path = (std::filesystem::temp_directory_path()/"bezier_bench_frame.png").string();
+		results.push_back(measure(options,"png_write_800x600",0,0.0f,[&] {
+			return PngWriter::Write(path,pixels.data(),width,height,true) ? size_t(width*height) : size_t(0);
+		}));
+		std::error_code error;
+		std::filesystem::remove(path,error);
+	}
+
+	//animation style queries, thousands of positions at lengths along one curve per frame
+	void runArcLengthBenchmarks(const Options& options, std::vector<Result>& results) {
+		const std::vector<size_t> pointCounts = options.quick ? std::vector<size_t>{4,64} : std::vector<size_t>{4,16,64,256};
+		const size_t queries = 4096;
+		for(const size_t count : pointCounts) {
+			BezierCurve curve;
+			fillCurve(curve,count);
+			std::vector<float> lengths(queries);
+			std::vector<glm::vec2> positions(queries);
+			const float length = curve.Length();
+			for(size_t i=0;i<queries;i++) {
+				lengths[i] = length*static_cast<float>((i*2654435761u)%queries)/queries;
+			}
+			results.push_back(measure(options,"arc_table_build",count,0.0f,[&] {
+				curve.SetPoint(0,curve.Points()[0]);
+				return static_cast<size_t>(curve.Length()>0.0f);
+			}));
+			results.push_back(measure(options,"arc_t_at_length",count,0.0f,[&] {
+				float sum = 0.0f;
+				for(const float l : lengths) {
+					sum += curve.TAtLength(l);
+				}
+				return static_cast<size_t>(sum>=0.0f ? queries : 0);
+			}));
+			results.push_back(measure(options,"arc_evaluate_at_lengths",count,0.0f,[&] {
+				curve.EvaluateAtLengths(lengths.data(),queries,positions.data());
+				return queries;
+			}));
+			curve.SetTessellationMode(BezierCurve::TessellationMode::ArcLength);
+			results.push_back(measure(options,"recalculate_arc_length",count,curve.GetPrecision(),[&] {
+				curve.SetPoint(0,curve.Points()[0]);
+				curve.RecalculateLine();
+				return curve.linePoints.size();
+			}));
+		}
+	}
+
+	//curves spread over a 32x32 tiling of windows while the view covers one window
+	void runCullBenchmarks(const Options& options, std::vector<Result>& results) {
+		const std::vector<size_t> pointCounts = options.quick ? std::vector<size_t>{4,64} : std::vector<size_t>{4,16,64};
+		for(const size_t count : pointCounts) {
+			BezierCurve curve;
+			fillCurve(curve,count);
+			results.push_back(measure(options,"curve_bounds",count,0.0f,[&] {
+				curve.SetPoint(0,curve.Points()[0]);
+				return static_cast<size_t>(!curve.Bounds().IsEmpty());
+			}));
+		}
+		ThreadPool pool;
+		const size_t curves = options.quick ? 1000 : 10000;
+		CurveScene scene;
+		for(size_t i=0;i<curves;i++) {
+			BezierCurve& curve = scene.curves[scene.AddCurve()];
+			fillCurve(curve,4+i%12);
+			const glm::vec2 tile(800.0f*(i%32),600.0f*(i/32%32));
+			for(size_t j=0;j<curve.Points().size();j++) {
+				curve.SetPoint(j,curve.Points()[j]+tile);
+			}
+		}
+		scene.SetView({glm::vec2(1000.0f,700.0f),glm::vec2(1800.0f,1300.0f)});
+		scene.BeginTessellation(pool);
+		scene.FinishTessellation(pool);
+		//only the curves in view are tessellated, the others keep their stale lines
+		size_t viewSamples = 0;
+		for(size_t i=0;i<scene.curves.size();i++) {
+			if(scene.curves[i].Bounds().Intersects(scene.View())) {
+				viewSamples += scene.LineSlice(i).count;
+			}
+		}
+		results.push_back(measure(options,"scene_tessellate_view",curves,0.01f,[&] {
+			scene.MarkAllDirty();
+			scene.BeginTessellation(pool);
+			scene.FinishTessellation(pool);
+			return viewSamples;
+		}));
+		results.push_back(measure(options,"scene_cull",curves,0.01f,[&] {
+			scene.Cull();
+			size_t visible = 0;
+			for(const CurveScene::Slice& line : scene.VisibleLines()) {
+				visible += line.count;
+			}
+			return visible;
+		}));
+		//zooming out and back in only switches levels of detail, nothing is tessellated again
+		size_t zoomStep = 0;
+		results.push_back(measure(options,"scene_zoom",curves,0.01f,[&] {
+			const float zoom = 1.0f/static_cast<float>(size_t(1)<<(zoomStep++%6));
+			scene.SetView({glm::vec2(0.0f),glm::vec2(800.0f,600.0f)/zoom},zoom);
+			scene.BeginTessellation(pool);
+			scene.FinishTessellation(pool);
+			scene.Cull();
+			size_t visible = 0;
+			for(const CurveScene::Slice& line : scene.VisibleLines()) {
+				visible += line.count;
+			}
+			return visible;
+		}));
+	}
+
+	//a scene of curves with 16 control points each: streaming it out, mapping it and reading every point, copying it into a CurveScene, and the text import for comparison
+	void runSceneFileBenchmarks(const Options& options, std::vector<Result>& results) {
+		const std::string path = (std::filesystem::temp_directory_path()/"bezier_bench_scene.bzs").string();
+		const std::string textPath = (std::filesystem::temp_directory_path()/"bezier_bench_scene.txt").string();
+		const size_t curvePoints = 16;
+		const std::vector<size_t> pointCounts = options.quick ? std::vector<size_t>{1<<20} : std::vector<size_t>{1<<16,1<<20,1<<24};
+		std::vector<glm::vec2> points;
+		fillPoints(points,curvePoints);
+		for(const size_t count : pointCounts) {
+			results.push_back(measure(options,"scene_file_write",count,0.01f,[&] {
+				SceneWriter writer(path);
+				for(size_t i=0;i<count;i+=curvePoints) {
+					writer.AddCurve(points.data(),curvePoints);
+				}
+				writer.Finish();
+				return count;
+			}));
+			results.push_back(measure(options,"scene_file_load",count,0.01f,[&] {
+				SceneFile scene(path);
+				//every page is touched, the time includes faulting the mapping in
+				glm::vec2 sum(0.0f);
+				for(size_t i=0;i<scene.PointCount();i++) {
+					sum += scene.Points()[i];
+				}
+				return sum.x!=0.0f ? scene.PointCount() : 0;
+			}));
+			if(count>(1<<20)) {
+				continue;
+			}
+			results.push_back(measure(options,"scene_file_to_scene",count,0.01f,[&] {
+				SceneFile file(path);
+				CurveScene scene;
+				scene.curves.reserve(file.CurveCount());
+				for(size_t i=0;i<file.CurveCount();i++) {
+					const SceneFile::Curve curve = file.CurveAt(i);
+					BezierCurve& target = scene.curves[scene.AddCurve()];
+					target.SetPrecision(curve.precision);
+					target.AddPoints(curve.points,curve.count);
+				}
+				return file.PointCount();
+			}));
+			{
+				std::ofstream text(textPath);
+				for(size_t i=0;i<count;i+=curvePoints) {
+					text << "curve\n";
+					for(const glm::vec2 point : points) {
+						text << point.x << " " << point.y << "\n";
+					}
+				}
+			}
+			results.push_back(measure(options,"scene_text_import",count,0.01f,[&] {
+				std::ifstream text(textPath);
+				SceneWriter writer(path);
+				SceneImport::Text(text,writer);
+				writer.Finish();
+				return count;
+			}));
+		}
+		std::error_code error;
+		std::filesystem::remove(path,error);
+		std::filesystem::remove(textPath,error);
+	}
+
+	//batches of projections and intersections against curves of 4 to 7 points spread over the window
+	void runQueryBenchmarks(const Options& options, std::vector<Result>& results) {
+		ThreadPool pool;
+		const size_t curveCount = 1000;
+		CurveQuery query;
+		std::vector<glm::vec2> points;
+		for(size_t i=0;i<curveCount;i++) {
+			fillPoints(points,4+i%4);
+			const glm::vec2 offset(static_cast<float>(i%37)*4.0f-72.0f,static_cast<float>(i%23)*6.0f-66.0f);
+			for(glm::vec2& point : points) {
+				point = point*0.5f+glm::vec2(200.0f,150.0f)+offset;
+			}
+			query.AddCurve(points.data(),points.size());
+		}
+		const size_t n = options.quick ? 100000 : 1000000;
+		std::vector<uint32_t> curvesA(n);
+		std::vector<uint32_t> curvesB(n);
+		std::vector<glm::vec2> queries(n);
+		for(size_t i=0;i<n;i++) {
+			curvesA[i] = static_cast<uint32_t>(i%curveCount);
+			curvesB[i] = static_cast<uint32_t>((i*7919+1)%curveCount);
+			queries[i] = glm::vec2(static_cast<float>((i*37)%800),static_cast<float>((i*101)%600));
+		}
+		CurveQuery::ClosestPointResults closest;
+		results.push_back(measure(options,"query_closest_point",n,query.Tolerance(),[&] {
+			query.ClosestPoints(curvesA.data(),queries.data(),n,closest,&pool);
+			return n;
+		}));
+		CurveQuery::IntersectionResults intersections;
+		results.push_back(measure(options,"query_intersect",n,query.Tolerance(),[&] {
+			query.Intersect(curvesA.data(),curvesB.data(),n,intersections,&pool);
+			return n;
+		}));
+	}
+
+	//cost of the instrumentation when it's compiled in, the scope is used directly since the bench builds without BEZIER_PROFILE
+	void runProfilerBenchmarks(const Options& options, std::vector<Result>& results) {
+		const size_t scopes = 1000;
+		const size_t section = Profiler::Section("bench");
+		Profiler::BeginFrame();
+		results.push_back(measure(options,"profiler_scope",scopes,0.0f,[&] {
+			for(size_t i=0;i<scopes;i++) {
+				const Profiler::Scope scope(section);
+			}
+			Profiler::BeginFrame();
+			return scopes;
+		}));
+	}
+
+	struct PickPoint {
+		uint32_t id;
+		glm::vec2 pos;
+		bool operator==(const PickPoint& other) const {
+			return id==other.id;
+		}
+	};
+
+	//nearest control point within the capture distance, a scan over every point against the grid
+	void runPickBenchmarks(const Options& options, std::vector<Result>& results) {
+		const std::vector<size_t> pointCounts = options.quick ? std::vector<size_t>{10000} : std::vector<size_t>{1000,10000,100000};
+		const float radius = 10.0f;
+		for(const size_t count : pointCounts) {
+			std::vector<PickPoint> points;
+			SpatialGrid<PickPoint> grid(radius);
+			for(size_t i=0;i<count;i++) {
+				const PickPoint p{static_cast<uint32_t>(i),{(i*7919)%800*1.0f,(i*104729)%600*1.0f}};
+				points.push_back(p);
+				grid.Insert(p,p.pos,p.pos);
+			}
+			//a sample is one query, hits only keep the search from being optimized out
+			size_t query = 0;
+			size_t hits = 0;
+			const auto nextQuery = [&] {
+				query++;
+				return glm::vec2((query*31)%800,(query*17)%600);
+			};
+			results.push_back(measure(options,"pick_point_linear",count,radius,[&] {
+				const glm::vec2 pos = nextQuery();
+				float closest = radius;
+				bool found = false;
+				for(const PickPoint& p : points) {
+					const float d = glm::length(p.pos-pos);
+					if(d<=closest) {
+						closest = d;
+						found = true;
+					}
+				}
+				hits += found;
+				return size_t(1);
+			}));
+			results.push_back(measure(options,"pick_point_grid",count,radius,[&] {
+				const glm::vec2 pos = nextQuery();
+				PickPoint nearest{};
+				float distance = 0.0f;
+				hits += grid.Nearest(pos,radius,[pos](const PickPoint& p) { return glm::length(p.pos-pos); },nearest,distance);
+				return size_t(1);
+			}));
+			if(hits==0) {
+				std::cout << "pick_point found nothing in " << count << " points" << std::endl;
+			}
+		}
+	}
+}
+
+int main(int argc, char** argv) {
+	Options options;
+	for(int i=1;i<argc;i++) {
+		if(std::strcmp(argv[i],"--quick")==0) {
+			options.quick = true;
+			options.minSeconds = 0.01;
+		}else if(std::strcmp(argv[i],"--out")==0 && i+1<argc) {
+			options.out = argv[++i];
+		}else if(std::strcmp(argv[i],"--baseline")==0 && i+1<argc) {
+			options.baseline = argv[++i];
+		}else if(std::strcmp(argv[i],"--tolerance")==0 && i+1<argc) {
+			options.tolerance = std::atof(argv[++i]);
+		}else {
+			std::cout << "usage: " << argv[0] << " [--quick] [--out results.json] [--baseline old.json] [--tolerance 0.15]" << std::endl;
+			return 2;
+		}
+	}
+
+	std::vector<Result> results;
+	runCurveBenchmarks(options,results);
+	runFixedDegreeBenchmarks(options,results);
+	runBackendBenchmarks(options,results);
+	runCompositeBenchmarks(options,results);
+	runSceneBenchmarks(options,results);
+	runAsyncBenchmarks(options,results);
+	runHeadlessBenchmarks(options,results);
+	runArcLengthBenchmarks(options,results);
+	runCullBenchmarks(options,results);
+	runProfilerBenchmarks(options,results);
+	runQueryBenchmarks(options,results);
+	runSceneFileBenchmarks(options,results);
+	runPickBenchmarks(options,results);
+
+	if(options.out.empty()) {
+		writeJson(std::cout,results);
+	}else {
+		std::ofstream file(options.out);
+		writeJson(file,results);
+		std::cout << "Wrote " << results.size() << " results to " << options.out << std::endl;
+	}
+
+	//a regression is a case slower than the baseline by more than the tolerance
+	if(!options.baseline.empty()) {
+		const std::map<std::string,double> baseline = readBaseline(options.baseline);
+		int regressions = 0;
+		for(const Result& r : results) {
+			const auto it = baseline.find(key(r));
+			if(it==baseline.end() || it->second<=0.0) {
+				continue;
+			}
+			const double ratio = r.nsPerCall/it->second;
+			if(ratio>1.0+options.tolerance) {
+				std::cout << "REGRESSION " << key(r) << ": " << it->second << " -> " << r.nsPerCall << " ns/call (x" << ratio << ")" << std::endl;
+				regressions++;
+			}
+		}
+		std::cout << regressions << " regressions against " << options.baseline << std::endl;
+		return regressions>0 ? 1 : 0;
+	}
+	return 0;
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include "BoundingBox.h"
+
+#include <vector>
+#include <memory_resource>
+#include <algorithm>
+#include <cstdint>
+
+//bounding volume hierarchy over a fixed set of boxes, built by median splits along the longer axis
+//nodes are stored depth first, so a node's left child follows it and refitting runs backwards over the nodes
+class BVH {
+public:
+    static constexpr uint32_t leafSize = 4;
+private:
+    struct Node {
+        BoundingBox box;
+        uint32_t first = 0; //leaf: first entry of order, inner: index of the right child
+        uint32_t count = 0; //0 for inner nodes
+    };
+    uint32_t build(const BoundingBox* boxes, const uint32_t first, const uint32_t count) {
+        const uint32_t index = static_cast<uint32_t>(nodes.size());
+        nodes.emplace_back();
+        BoundingBox box;
+        BoundingBox centers;
+        for(uint32_t i=first;i<first+count;i++) {
+            box.Extend(boxes[order[i]]);
+            centers.Extend(boxes[order[i]].Center());
+        }
+        nodes[index].box = box;
+        if(count<=leafSize) {
+            nodes[index].first = first;
+            nodes[index].count = count;
+            return index;
+        }
+        const int axis = centers.max.x-centers.min.x>=centers.max.y-centers.min.y ? 0 : 1;
+        const uint32_t half = count/2;
+        std::nth_element(order.begin()+first,order.begin()+first+half,order.begin()+first+count,[&](const uint32_t a, const uint32_t b) {
+            return boxes[a].Center()[axis]<boxes[b].Center()[axis];
+        });
+        build(boxes,first,half);
+        const uint32_t right = build(boxes,first+half,count-half);
+        nodes[index].first = right;
+        return index;
+    }
+    std::pmr::vector<Node> nodes;
+    std::pmr::vector<uint32_t> order;
+public:
+    explicit BVH(std::pmr::memory_resource* resource = std::pmr::get_default_resource()):nodes(resource),order(resource) {}
+    void Build(const BoundingBox* boxes, const size_t count) {
+        nodes.clear();
+        order.resize(count);
+        for(size_t i=0;i<count;i++) {
+            order[i] = static_cast<uint32_t>(i);
+        }
+        if(count>0) {
+            build(boxes,0,static_cast<uint32_t>(count));
+        }
+    }
+    //same items with moved boxes, the tree gets looser but stays correct
+    void Refit(const BoundingBox* boxes) {
+        for(size_t i=nodes.size();i-->0;) {
+            Node& node = nodes[i];
+            BoundingBox box;
+            if(node.count>0) {
+                for(uint32_t j=node.first;j<node.first+node.count;j++) {
+                    box.Extend(boxes[order[j]]);
+                }
+            }else {
+                box.Extend(nodes[i+1].box);
+                box.Extend(nodes[node.first].box);
+            }
+            node.box = box;
+        }
+    }
+    //f(item) for every item whose box in boxes intersects box
+    template<class F>
+    void Query(const BoundingBox& box, const BoundingBox* boxes, F f) const {
+        if(nodes.empty()) {
+            return;
+        }
+        uint32_t stack[64];//depth is log2 of the item count
+        int top = 0;
+        stack[top++] = 0;
+        while(top>0) {
+            const Node& node = nodes[stack[--top]];
+            if(!node.box.Intersects(box)) {
+                continue;
+            }
+            if(node.count>0) {
+                for(uint32_t j=node.first;j<node.first+node.count;j++) {
+                    if(boxes[order[j]].Intersects(box)) {
+                        f(order[j]);
+                    }
+                }
+                continue;
+            }
+            const uint32_t index = static_cast<uint32_t>(&node-nodes.data());
+            stack[top++] = node.first;
+            stack[top++] = index+1;
+        }
+    }
+    size_t Size() const {
+        return order.size();
+    }
+};
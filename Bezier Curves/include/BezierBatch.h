@@ -0,0 +1,33 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+
+//evaluates many t values of one curve at once, 4/8/16 lanes per instruction depending on the cpu
+namespace BezierBatch {
+	enum class InstructionSet {
+		Scalar,
+		SSE,
+		AVX2,
+		AVX512
+	};
+
+	//best instruction set supported by the cpu and the os
+	InstructionSet Detect();
+	//instruction set Evaluate is currently dispatched to
+	InstructionSet Active();
+	//limited to what Detect reports, mostly for comparing the kernels
+	void SetActive(InstructionSet set);
+	const char* Name(InstructionSet set);
+
+	//wx/wy hold C(n,i)*P_i for i=0..count-1 as structure of arrays
+	void Evaluate(const float* wx, const float* wy, size_t count, const float* ts, size_t n, glm::vec2* out);
+
+	//most rows of differences StepForward keeps in registers
+	constexpr size_t maxStepRows = 8;
+	//blocks of width floats from forward differences, width a multiple of 32 and rows from 2 to maxStepRows
+	//row m is seeded in double with the sum over j of weights[m][j]*values[j] per element, weights holds rows*rows blocks of width doubles and values rows
+	//the first block written to out is row 0, before each following one every row is added onto the one below it
+	void StepForward(const double* weights, const double* values, size_t rows, size_t width, size_t steps, float* out);
+}
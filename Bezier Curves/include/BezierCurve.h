@@ -2,48 +2,933 @@
 
 #include <glm/glm.hpp>
 
+#include "BezierBatch.h"
+#include "BoundingBox.h"
+
 #include <vector>
+#include <memory_resource>
+#include <algorithm>
+#include <cmath>
+#include <chrono>
+#include <cstdint>
+#include <limits>
 
 
 inline glm::vec2 Lerp(const glm::vec2 p1, const glm::vec2 p2, const float t) {
     return p1 + (p2-p1)*t;
 }
 class BezierCurve {
+public:
+    enum class EvaluationMode {
+        DeCasteljau,      //reference, O(n^2) lerps per sample
+        Bernstein,        //precomputed binomial weights, O(n) per sample
+        ForwardDifference //O(n) additions per sample, Bernstein where the difference table can't be kept accurate
+    };
+    enum class TessellationMode {
+        Uniform,  //fixed step of precision
+        Adaptive, //subdivides until every segment is within flatnessTolerance of the curve
+        ArcLength //as many vertices as Uniform, spaced evenly along the curve
+    };
+    //number type the uniform samples are calculated in, they are stored as floats either way
+    enum class ScalarBackend {
+        Float,  //evaluation mode in float, the fastest
+        Double, //evaluation mode in double, rounded once at the end
+        Fixed   //de Casteljau on integers around the center of the control points, as exact far from the origin as near it
+    };
+    struct TessellationStats {
+        size_t vertexCount = 0;
+        double microseconds = 0.0;
+        //max distance of the uniform samples from the double reference, only measured while error tracking is on
+        float maxError = 0.0f;
+    };
+    //stays valid while other points are added or erased, unlike an index or a pointer into the points
+    struct PointHandle {
+        uint32_t slot = UINT32_MAX;
+        uint32_t generation = 0;
+    };
+    //range of linePoints changed by an edit
+    struct DirtyRange {
+        size_t first = 0;
+        size_t count = 0;
+    };
+    //basis weights below this don't change a float sample
+    static constexpr double basisEpsilon = 1e-7;
+    //full recalculation after this many incremental moves, to bound accumulated rounding error
+    static constexpr int maxIncrementalMoves = 256;
+    //2^16 segments at most in adaptive mode
+    static constexpr int maxSubdivisionDepth = 16;
+    //binomial coefficients above this overflow double
+    static constexpr size_t maxBernsteinPoints = 1000;
+    //bound on the distance of forward difference samples from the curve, in units of the points
+    static constexpr double forwardDifferenceTolerance = 1e-3;
+    //float weights of the batch evaluator overflow or lose too much precision above this
+    static constexpr size_t maxBatchPoints = 100;
+    //segments per control point the arc length table starts with, and its limits
+    static constexpr size_t arcSegmentsPerPoint = 32;
+    static constexpr size_t minArcSegments = 256;
+    static constexpr size_t maxArcSegments = 4096;
+    //pixels the table's lengths may be off from the arc
+    static constexpr float arcLengthTolerance = 0.01f;
+    //derivative root isolation gives up splitting below this and takes the middle of the interval
+    static constexpr int maxRootDepth = 40;
+    static constexpr int maxRootIterations = 60;
+    //fixed point samples keep their control points below 2^30 and t has 31 fraction bits, so every product fits 64 bits
+    static constexpr int fixedPointBits = 30;
+    static constexpr int fixedTBits = 31;
 private:
+    //de Casteljau in the scalar type of Vec, tmp holds the points of every level
+    template<class Vec, class Scalar>
+    Vec calcLinePoint(std::pmr::vector<Vec>& tmp, const Scalar t) const {
+        tmp.resize(points.size());
+        for(size_t i=0;i<points.size();i++) {
+            tmp[i] = Vec(points[i]);
+        }
+        size_t count = tmp.size();
+        while(count>1) {
+            for(size_t i=0;i<count-1;i++) {
+                tmp[i] = tmp[i]+(tmp[i+1]-tmp[i])*t;
+            }
+            count--;
+        }
+        return tmp[0];
+    }
     glm::vec2 calcLinePoint(const float t) {
         if(points.size()<2) {
             return {0,0};
         }
-        std::vector<glm::vec2> tmp_points(points);
-        while(tmp_points.size()>2) {
-            for(int i=0;i<tmp_points.size()-1;i++) {
-                tmp_points[i] = Lerp(tmp_points[i],tmp_points[i+1],t);
+        return calcLinePoint(tmp_points,t);
+    }
+    //t of uniform sample i, the last one is exactly 1 whatever the precision
+    double calcSampleT(const size_t i) const {
+        return sampleCount>1 ? static_cast<double>(i)/static_cast<double>(sampleCount-1) : 0.0;
+    }
+    //sum(C(n,i) * t^i * (1-t)^(n-i) * P_i), horner-like scheme without divisions
+    glm::dvec2 calcBernsteinPoint(const double t) const {
+        const double s = 1.0-t;
+        glm::dvec2 acc = weights[0];
+        double tn = 1.0;
+        for(size_t i=1;i<weights.size();i++) {
+            tn *= t;
+            acc = acc*s + weights[i]*tn;
+        }
+        return acc;
+    }
+    void calcWeights() {
+        const size_t n = points.size()-1;
+        weights.resize(points.size());
+        double binomial = 1.0;
+        for(size_t i=0;i<=n;i++) {
+            weights[i] = glm::dvec2(points[i])*binomial;
+            binomial = binomial*static_cast<double>(n-i)/static_cast<double>(i+1);
+        }
+    }
+    void calcBatchWeights() {
+        batchWeightsX.resize(weights.size());
+        batchWeightsY.resize(weights.size());
+        for(size_t i=0;i<weights.size();i++) {
+            batchWeightsX[i] = static_cast<float>(weights[i].x);
+            batchWeightsY[i] = static_cast<float>(weights[i].y);
+        }
+    }
+    void calcSampleTs() {
+        sampleTs.resize(sampleCount);
+        for(size_t i=0;i<sampleTs.size();i++) {
+            sampleTs[i] = static_cast<float>(calcSampleT(i));
+        }
+    }
+    //B_k(t_j) for every sample, only the range above basisEpsilon is kept
+    void calcBasisColumn(const size_t k) {
+        const size_t n = points.size()-1;
+        const double logBinomial = std::lgamma(n+1.0)-std::lgamma(k+1.0)-std::lgamma(n-k+1.0);
+        basisColumn.resize(sampleCount);
+        basisRange = {sampleCount,0};
+        for(size_t j=0;j<sampleCount;j++) {
+            const double t = calcSampleT(j);
+            double b;
+            if(t<=0.0) {
+                b = k==0 ? 1.0 : 0.0;
+            }else if(t>=1.0) {
+                b = k==n ? 1.0 : 0.0;
+            }else {
+                b = std::exp(logBinomial + k*std::log(t) + (n-k)*std::log(1.0-t));
+            }
+            basisColumn[j] = static_cast<float>(b);
+            if(b>basisEpsilon) {
+                if(basisRange.first>j) {
+                    basisRange.first = j;
+                }
+                basisRange.count = j-basisRange.first+1;
+            }
+        }
+        if(basisRange.count==0) {
+            basisRange.first = 0;
+        }
+        basisIndex = k;
+        basisPoints = points.size();
+        basisPrecision = precision;
+    }
+    void calcSampleCount() {
+        sampleCount = static_cast<size_t>(1.0f/precision+1);
+        linePoints.clear();
+        linePoints.resize(sampleCount);
+        calcSampleTs();
+    }
+    //cumulative lengths at evenly spaced t, every segment from its chord and the two half chords through its midpoint
+    //(4*halves-chord)/3 cancels the h^2 term of the chord error, (halves-chord)/3 summed up bounds what is left of it
+    //lookups interpolate linearly in a segment, which is off by about half the difference of its halves at the midpoint
+    //the table is rebuilt with as many more segments as both need to be within arcLengthTolerance, up to maxArcSegments
+    void calcArcTable() {
+        const bool slow = points.size()>maxBernsteinPoints;
+        size_t segments = slow ? minArcSegments : std::clamp(points.size()*arcSegmentsPerPoint,minArcSegments,maxArcSegments);
+        while(true) {
+            const size_t halves = 2*segments;
+            arcTs.resize(halves+1);
+            for(size_t i=0;i<=halves;i++) {
+                arcTs[i] = static_cast<float>(i)/static_cast<float>(halves);
+            }
+            arcPoints.resize(halves+1);
+            EvaluateBatch(arcTs.data(),arcTs.size(),arcPoints.data());
+            arcLengths.resize(segments+1);
+            arcLengths[0] = 0.0f;
+            double length = 0.0;
+            double estimate = 0.0;
+            double interpolation = 0.0;
+            for(size_t i=1;i<=segments;i++) {
+                const glm::vec2 a = arcPoints[2*i-2];
+                const glm::vec2 m = arcPoints[2*i-1];
+                const glm::vec2 b = arcPoints[2*i];
+                const double chord = glm::length(b-a);
+                const double first = glm::length(m-a);
+                const double second = glm::length(b-m);
+                length += (4.0*(first+second)-chord)/3.0;
+                estimate += (first+second-chord)/3.0;
+                interpolation = std::max(interpolation,std::abs(first-second)/2.0);
+                arcLengths[i] = static_cast<float>(length);
+            }
+            const double error = std::max(estimate,interpolation);
+            if(slow || error<=arcLengthTolerance || segments>=maxArcSegments) {
+                break;
+            }
+            //both errors shrink with the square of the segment length
+            segments = std::min(static_cast<size_t>(std::ceil(static_cast<double>(segments)*std::sqrt(error/arcLengthTolerance)*1.05)),maxArcSegments);
+        }
+        //table index at the start of every equal length bucket, a lookup then only steps over the few chords in its bucket
+        arcBuckets.resize(segments+1);
+        size_t i = 0;
+        for(size_t j=0;j<=segments;j++) {
+            const float bucketStart = arcLengths.back()*static_cast<float>(j)/static_cast<float>(segments);
+            while(i+1<segments && arcLengths[i+1]<=bucketStart) {
+                i++;
+            }
+            arcBuckets[j] = static_cast<uint32_t>(i);
+        }
+        arcTableValid = true;
+    }
+    void calcArcLengthLine() {
+        linePoints.resize(sampleCount);
+        arcQueryLengths.resize(sampleCount);
+        const float length = Length();
+        for(size_t i=0;i<sampleCount;i++) {
+            arcQueryLengths[i] = sampleCount>1 ? length*static_cast<float>(i)/static_cast<float>(sampleCount-1) : 0.0f;
+        }
+        EvaluateAtLengths(arcQueryLengths.data(),sampleCount,linePoints.data());
+    }
+    //value of a polynomial given by Bernstein coefficients that are already multiplied by their binomials
+    static double calcScaledBernsteinValue(const double* c, const size_t count, const double t) {
+        const double s = 1.0-t;
+        double acc = c[0];
+        double tn = 1.0;
+        for(size_t i=1;i<count;i++) {
+            tn *= t;
+            acc = acc*s+c[i]*tn;
+        }
+        return acc;
+    }
+    //the single root in [0,1] of coefficients with one sign change, regula falsi with the Illinois modification
+    static double calcBernsteinRoot(double* c, const size_t count) {
+        double binomial = 1.0;
+        for(size_t i=0;i<count;i++) {
+            c[i] *= binomial;
+            binomial = binomial*static_cast<double>(count-1-i)/static_cast<double>(i+1);
+        }
+        double lo = 0.0;
+        double hi = 1.0;
+        double fLo = c[0];
+        double fHi = c[count-1];
+        if(fLo==0.0 || fHi==0.0) {
+            return fLo==0.0 ? 0.0 : 1.0;
+        }
+        double t = 0.5;
+        int side = 0;
+        for(int i=0;i<maxRootIterations && hi-lo>1e-12;i++) {
+            t = (lo*fHi-hi*fLo)/(fHi-fLo);
+            const double f = calcScaledBernsteinValue(c,count,t);
+            if(f==0.0) {
+                break;
+            }
+            if((f<0.0)==(fLo<0.0)) {
+                lo = t;
+                fLo = f;
+                if(side==-1) {
+                    fHi *= 0.5;
+                }
+                side = -1;
+            }else {
+                hi = t;
+                fHi = f;
+                if(side==1) {
+                    fLo *= 0.5;
+                }
+                side = 1;
             }
-            tmp_points.pop_back();
         }
-        return Lerp(tmp_points[0],tmp_points[1],t);
+        return t;
     }
+    //roots of one coordinate of the derivative in (0,1), appended to boundsTs
+    //a piece whose Bernstein coefficients don't change sign has no root, one sign change means exactly one root
+    void calcDerivativeRoots(const int axis) {
+        const size_t count = points.size()-1;
+        rootStack.resize(count);
+        for(size_t i=0;i<count;i++) {
+            rootStack[i] = static_cast<double>(points[i+1][axis]-points[i][axis]);
+        }
+        rootIntervals.assign(1,glm::dvec3(0.0,1.0,0.0));
+        while(!rootIntervals.empty()) {
+            const glm::dvec3 interval = rootIntervals.back();
+            rootIntervals.pop_back();
+            const size_t base = rootStack.size()-count;
+            const double* c = &rootStack[base];
+            int changes = 0;
+            double lastSign = 0.0;
+            for(size_t i=0;i<count;i++) {
+                const double sign = c[i]>0.0 ? 1.0 : c[i]<0.0 ? -1.0 : 0.0;
+                if(sign!=0.0) {
+                    changes += lastSign!=0.0 && sign!=lastSign;
+                    lastSign = sign;
+                }
+            }
+            if(changes==0) {
+                rootStack.resize(base);
+                continue;
+            }
+            if(changes==1 || interval.z>=maxRootDepth) {
+                const double t = changes==1 ? calcBernsteinRoot(&rootStack[base],count) : 0.5;
+                boundsTs.push_back(interval.x+(interval.y-interval.x)*t);
+                rootStack.resize(base);
+                continue;
+            }
+            //de Casteljau split at the middle, the left half goes on top
+            rootStack.resize(base+2*count);
+            double* right = &rootStack[base];
+            double* left = &rootStack[base+count];
+            std::copy(right,right+count,left);
+            for(size_t r=1;r<count;r++) {
+                for(size_t i=count-1;i>=r;i--) {
+                    left[i] = (left[i-1]+left[i])*0.5;
+                }
+                right[count-1-r] = left[count-1];
+            }
+            const double mid = (interval.x+interval.y)*0.5;
+            rootIntervals.push_back({mid,interval.y,interval.z+1});
+            rootIntervals.push_back({interval.x,mid,interval.z+1});
+        }
+    }
+    //the extremes are at the ends or where a coordinate of the derivative is 0
+    void calcBounds() {
+        bounds = BoundingBox();
+        boundsValid = true;
+        if(points.size()<2 || points.size()>maxBernsteinPoints) {
+            for(const glm::vec2 p : points) {//the control polygon's box contains the curve
+                bounds.Extend(p);
+            }
+            return;
+        }
+        boundsTs.assign({0.0,1.0});
+        calcDerivativeRoots(0);
+        calcDerivativeRoots(1);
+        calcWeights();
+        for(const double t : boundsTs) {
+            bounds.Extend(glm::vec2(calcBernsteinPoint(t)));
+        }
+    }
+    //max distance of the inner control points from the chord, the curve lies within it
+    bool isFlat(const glm::vec2* p, const size_t count) const {
+        const glm::vec2 chord = p[count-1]-p[0];
+        const float chordLength2 = glm::dot(chord,chord);
+        const float tolerance2 = flatnessTolerance*flatnessTolerance;
+        for(size_t i=1;i+1<count;i++) {
+            const glm::vec2 d = p[i]-p[0];
+            const float t = chordLength2>0.0f ? glm::clamp(glm::dot(d,chord)/chordLength2,0.0f,1.0f) : 0.0f;
+            const glm::vec2 offset = d-chord*t;
+            if(glm::dot(offset,offset)>tolerance2) {
+                return false;
+            }
+        }
+        return true;
+    }
+    //depth first subdivision with an explicit stack of control polygons, left halves are emitted first
+    void calcAdaptiveLine() {
+        const size_t count = points.size();
+        const size_t n = count-1;
+        linePoints.clear();
+        linePoints.push_back(points[0]);
+        subdivisionStack.assign(points.begin(),points.end());
+        subdivisionDepths.assign(1,0);
+        while(!subdivisionDepths.empty()) {
+            const int depth = subdivisionDepths.back();
+            subdivisionDepths.pop_back();
+            const size_t base = subdivisionStack.size()-count;
+            if(depth>=maxSubdivisionDepth || isFlat(&subdivisionStack[base],count)) {
+                linePoints.push_back(subdivisionStack[base+n]);
+                subdivisionStack.resize(base);
+                continue;
+            }
+            tmp_points.assign(subdivisionStack.begin()+base,subdivisionStack.end());
+            subdivisionStack.resize(base+2*count);
+            glm::vec2* right = &subdivisionStack[base];
+            glm::vec2* left = &subdivisionStack[base+count];
+            left[0] = tmp_points[0];
+            right[n] = tmp_points[n];
+            for(size_t r=1;r<=n;r++) {
+                for(size_t i=0;i+r<=n;i++) {
+                    tmp_points[i] = (tmp_points[i]+tmp_points[i+1])*0.5f;
+                }
+                left[r] = tmp_points[0];
+                right[n-r] = tmp_points[n-r];
+            }
+            subdivisionDepths.push_back(depth+1);
+            subdivisionDepths.push_back(depth+1);
+        }
+    }
+    void calcUniformLine(glm::vec2* out, const ScalarBackend backend) {
+        if(points.size()<2) {
+            std::fill(out,out+sampleCount,glm::vec2(0,0));
+            return;
+        }
+        EvaluationMode mode = evaluationMode;
+        if(mode != EvaluationMode::DeCasteljau && points.size()>maxBernsteinPoints) {
+            mode = EvaluationMode::DeCasteljau;
+        }
+        size_t interval = 0;
+        if(mode == EvaluationMode::ForwardDifference) {
+            interval = calcForwardDifferenceInterval();
+            if(interval==0) {
+                mode = EvaluationMode::Bernstein;
+            }
+        }
+        if(backend == ScalarBackend::Fixed && calcFixedPoints()) {
+            calcFixedLine(out);
+            return;
+        }
+        if(backend != ScalarBackend::Float) {
+            //forward differences already add up in double, their error grows with the sample count anyway
+            if(mode == EvaluationMode::DeCasteljau) {
+                for(size_t i=0;i<sampleCount;i++) {
+                    out[i] = glm::vec2(calcLinePoint(tmp_dpoints,calcSampleT(i)));
+                }
+            }else {
+                calcWeights();
+                for(size_t i=0;i<sampleCount;i++) {
+                    out[i] = glm::vec2(calcBernsteinPoint(calcSampleT(i)));
+                }
+            }
+            return;
+        }
+        switch(mode) {
+        case EvaluationMode::DeCasteljau:
+            for(size_t i=0;i<sampleCount;i++) {
+                out[i] = calcLinePoint(sampleTs[i]);
+            }
+            break;
+        case EvaluationMode::Bernstein:
+            EvaluateBatch(sampleTs.data(),sampleTs.size(),out);
+            break;
+        case EvaluationMode::ForwardDifference:
+            calcWeights();
+            for(size_t i=0;i<sampleCount;i++) {
+                if(i%interval==0) {
+                    calcForwardDifferences(i);
+                }
+                out[i] = glm::vec2(differences[0]);
+                for(size_t k=0;k+1<differences.size();k++) {
+                    differences[k] += differences[k+1];
+                }
+            }
+            //the sums drift, the end point is known exactly
+            out[sampleCount-1] = points.back();
+            break;
+        }
+    }
+    //control points relative to the center of their box with fixedShift fraction bits, the largest shift that keeps them below 2^fixedPointBits
+    //false when the curve is too large for any shift
+    bool calcFixedPoints() {
+        glm::dvec2 lo(points[0]);
+        glm::dvec2 hi(points[0]);
+        for(const glm::vec2 p : points) {
+            lo = glm::min(lo,glm::dvec2(p));
+            hi = glm::max(hi,glm::dvec2(p));
+        }
+        fixedOrigin = (lo+hi)*0.5;
+        int exponent = 0;
+        std::frexp(std::max(hi.x-lo.x,hi.y-lo.y)*0.5,&exponent);
+        fixedShift = fixedPointBits-exponent;
+        if(fixedShift<0) {
+            return false;
+        }
+        const double scale = std::ldexp(1.0,fixedShift);
+        fixedX.resize(points.size());
+        fixedY.resize(points.size());
+        for(size_t i=0;i<points.size();i++) {
+            fixedX[i] = std::llround((points[i].x-fixedOrigin.x)*scale);
+            fixedY[i] = std::llround((points[i].y-fixedOrigin.y)*scale);
+        }
+        return true;
+    }
+    static int64_t fixedLerp(const int64_t a, const int64_t b, const int64_t t) {
+        return a+(((b-a)*t+(int64_t(1)<<(fixedTBits-1)))>>fixedTBits);
+    }
+    //t is i/(sampleCount-1) with fixedTBits fraction bits, stepped as quotient and remainder so it stays exact and hits 1 at the end
+    void calcFixedLine(glm::vec2* out) {
+        const double scale = std::ldexp(1.0,-fixedShift);
+        const size_t count = fixedX.size();
+        const int64_t last = static_cast<int64_t>(std::max<size_t>(sampleCount,2)-1);
+        const int64_t stepQuotient = (int64_t(1)<<fixedTBits)/last;
+        const int64_t stepRemainder = (int64_t(1)<<fixedTBits)%last;
+        fixedTmpX.resize(count);
+        fixedTmpY.resize(count);
+        const int64_t* px = fixedX.data();
+        const int64_t* py = fixedY.data();
+        int64_t* x = fixedTmpX.data();
+        int64_t* y = fixedTmpY.data();
+        int64_t t = 0;
+        int64_t remainder = 0;
+        for(size_t i=0;i<sampleCount;i++) {
+            std::copy(px,px+count,x);
+            std::copy(py,py+count,y);
+            for(size_t c=count;c>1;c--) {
+                for(size_t j=0;j+1<c;j++) {
+                    x[j] = fixedLerp(x[j],x[j+1],t);
+                    y[j] = fixedLerp(y[j],y[j+1],t);
+                }
+            }
+            out[i] = glm::vec2(fixedOrigin+glm::dvec2(static_cast<double>(x[0]),static_cast<double>(y[0]))*scale);
+            t += stepQuotient;
+            remainder += stepRemainder;
+            if(remainder>=last) {
+                t++;
+                remainder -= last;
+            }
+        }
+    }
+    //distance of every uniform sample from de Casteljau in double at the same t
+    float calcMaxError(const glm::vec2* line) {
+        if(points.size()<2) {
+            return 0.0f;
+        }
+        double maxError = 0.0;
+        for(size_t i=0;i<sampleCount;i++) {
+            const glm::dvec2 d = glm::dvec2(line[i])-calcLinePoint(tmp_dpoints,calcSampleT(i));
+            maxError = std::max(maxError,std::sqrt(d.x*d.x+d.y*d.y));
+        }
+        return static_cast<float>(maxError);
+    }
+    //the table of order j is seeded with an error of about 2^j rounding errors of a sample, which reaches k samples later multiplied by C(k,j)
+    //samples between seeds for that to stay within forwardDifferenceTolerance, 0 when seeding that often costs more than Bernstein
+    size_t calcForwardDifferenceInterval() const {
+        const size_t n = points.size()-1;
+        double magnitude = 0.0;
+        for(const glm::vec2 p : points) {
+            magnitude = std::max({magnitude,std::abs(static_cast<double>(p.x)),std::abs(static_cast<double>(p.y))});
+        }
+        const double sampleError = std::numeric_limits<double>::epsilon()*static_cast<double>(n+1)*std::max(magnitude,1.0);
+        const auto seedError = [n,sampleError](const size_t k) {
+            double sum = 0.0;
+            double binomial = 1.0;
+            double power = 1.0;
+            for(size_t j=0;j<=n && j<=k;j++) {
+                sum += binomial*power;
+                binomial = binomial*static_cast<double>(k-j)/static_cast<double>(j+1);
+                power *= 2.0;
+            }
+            return sum*sampleError;
+        };
+        if(seedError(points.size())>forwardDifferenceTolerance) {
+            return 0;
+        }
+        size_t interval = points.size();
+        while(interval<sampleCount && seedError(std::min(interval*2,sampleCount))<=forwardDifferenceTolerance) {
+            interval = std::min(interval*2,sampleCount);
+        }
+        return interval;
+    }
+    //differences of all orders at sample first for the sample step, then each following sample is n additions
+    void calcForwardDifferences(const size_t first) {
+        const size_t n = points.size()-1;
+        differences.resize(n+1);
+        for(size_t i=0;i<=n;i++) {
+            differences[i] = calcBernsteinPoint(calcSampleT(first+i));
+        }
+        for(size_t k=1;k<=n;k++) {
+            for(size_t i=n;i>=k;i--) {
+                differences[i] -= differences[i-1];
+            }
+        }
+    }
+    //every buffer below comes from here, so steady state edits and zooms only reuse capacity
+    std::pmr::memory_resource* memoryResource;
     float precision = 0.01f;
+    size_t sampleCount = 0;
+    float flatnessTolerance = 0.25f;
+    TessellationMode tessellationMode = TessellationMode::Uniform;
+    TessellationStats stats;
+    EvaluationMode evaluationMode = EvaluationMode::Bernstein;
+    ScalarBackend scalarBackend = ScalarBackend::Float;
+    bool errorTracking = false;
+    std::pmr::vector<glm::vec2> points{memoryResource};
+    //handle slot of every point and point index of every slot, UINT32_MAX for free slots
+    std::pmr::vector<uint32_t> pointSlots{memoryResource};
+    std::pmr::vector<uint32_t> slotIndices{memoryResource};
+    std::pmr::vector<uint32_t> slotGenerations{memoryResource};
+    std::pmr::vector<uint32_t> freeSlots{memoryResource};
+    std::pmr::vector<glm::vec2> tmp_points{memoryResource};
+    std::pmr::vector<glm::dvec2> tmp_dpoints{memoryResource};
+    std::pmr::vector<int64_t> fixedX{memoryResource};
+    std::pmr::vector<int64_t> fixedY{memoryResource};
+    std::pmr::vector<int64_t> fixedTmpX{memoryResource};
+    std::pmr::vector<int64_t> fixedTmpY{memoryResource};
+    glm::dvec2 fixedOrigin{0.0,0.0};
+    int fixedShift = 0;
+    //samples of the backend being measured, linePoints stays as it is
+    std::pmr::vector<glm::vec2> backendLine{memoryResource};
+    std::pmr::vector<glm::dvec2> weights{memoryResource};
+    std::pmr::vector<glm::dvec2> differences{memoryResource};
+    std::pmr::vector<float> batchWeightsX{memoryResource};
+    std::pmr::vector<float> batchWeightsY{memoryResource};
+    std::pmr::vector<float> sampleTs{memoryResource};
+    std::pmr::vector<float> basisColumn{memoryResource};
+    std::pmr::vector<glm::vec2> subdivisionStack{memoryResource};
+    std::pmr::vector<int> subdivisionDepths{memoryResource};
+    std::pmr::vector<float> arcTs{memoryResource};
+    std::pmr::vector<glm::vec2> arcPoints{memoryResource};
+    std::pmr::vector<float> arcLengths{memoryResource};
+    std::pmr::vector<uint32_t> arcBuckets{memoryResource};
+    std::pmr::vector<float> arcQueryLengths{memoryResource};
+    std::pmr::vector<float> arcQueryTs{memoryResource};
+    //built by the first length query after an edit
+    bool arcTableValid = false;
+    std::pmr::vector<double> rootStack{memoryResource};
+    std::pmr::vector<glm::dvec3> rootIntervals{memoryResource};
+    std::pmr::vector<double> boundsTs{memoryResource};
+    BoundingBox bounds;
+    bool boundsValid = false;
+    DirtyRange basisRange;
+    size_t basisIndex = 0;
+    size_t basisPoints = 0;
+    float basisPrecision = 0.0f;
+    //whether the last full calculation used the current point layout, incremental moves need it
+    bool lineValid = false;
+    int incrementalMoves = 0;
 public:
-	std::vector<glm::vec2> points;
-	std::vector<glm::vec2> linePoints;
-    BezierCurve() {
-        linePoints.clear();
-        linePoints.resize(1.0f/precision+1);
+	std::pmr::vector<glm::vec2> linePoints{memoryResource};
+    explicit BezierCurve(std::pmr::memory_resource* resource = std::pmr::get_default_resource()):memoryResource(resource) {
+        calcSampleCount();
+    }
+    const std::pmr::vector<glm::vec2>& Points() const {
+        return points;
+    }
+    std::pmr::memory_resource* GetMemoryResource() const {
+        return memoryResource;
+    }
+    PointHandle AddPoint(const glm::vec2 pos) {
+        uint32_t slot;
+        if(!freeSlots.empty()) {
+            slot = freeSlots.back();
+            freeSlots.pop_back();
+        }else {
+            slot = static_cast<uint32_t>(slotIndices.size());
+            slotIndices.push_back(UINT32_MAX);
+            slotGenerations.push_back(0);
+        }
+        slotIndices[slot] = static_cast<uint32_t>(points.size());
+        pointSlots.push_back(slot);
+        points.push_back(pos);
+        lineValid = false;
+        arcTableValid = false;
+        boundsValid = false;
+        return {slot,slotGenerations[slot]};
+    }
+    //appends many points with one allocation per array, the handles are HandleAt of their indices
+    void AddPoints(const glm::vec2* pos, const size_t count) {
+        points.reserve(points.size()+count);
+        pointSlots.reserve(pointSlots.size()+count);
+        slotIndices.reserve(slotIndices.size()+count);
+        slotGenerations.reserve(slotGenerations.size()+count);
+        for(size_t i=0;i<count;i++) {
+            AddPoint(pos[i]);
+        }
+    }
+    //handles of the later points stay valid, their indices shift down by one
+    void ErasePoint(const PointHandle handle) {
+        if(!IsValid(handle)) {
+            return;
+        }
+        const size_t index = slotIndices[handle.slot];
+        points.erase(points.begin()+index);
+        pointSlots.erase(pointSlots.begin()+index);
+        for(size_t i=index;i<pointSlots.size();i++) {
+            slotIndices[pointSlots[i]] = static_cast<uint32_t>(i);
+        }
+        slotIndices[handle.slot] = UINT32_MAX;
+        slotGenerations[handle.slot]++;
+        freeSlots.push_back(handle.slot);
+        lineValid = false;
+        arcTableValid = false;
+        boundsValid = false;
+    }
+    void ClearPoints() {
+        while(!points.empty()) {
+            ErasePoint(HandleAt(points.size()-1));
+        }
+    }
+    bool IsValid(const PointHandle handle) const {
+        return handle.slot<slotIndices.size() && slotIndices[handle.slot]!=UINT32_MAX && slotGenerations[handle.slot]==handle.generation;
+    }
+    size_t IndexOf(const PointHandle handle) const {
+        return slotIndices[handle.slot];
+    }
+    PointHandle HandleAt(const size_t index) const {
+        const uint32_t slot = pointSlots[index];
+        return {slot,slotGenerations[slot]};
+    }
+    //plain assignment, the line is only updated by the next RecalculateLine
+    void SetPoint(const size_t index, const glm::vec2 pos) {
+        points[index] = pos;
+        lineValid = false;
+        arcTableValid = false;
+        boundsValid = false;
     }
     void RecalculateLine() {
-        float t = 0;
-        for(int i=0;i<linePoints.size();i++) {
-            linePoints[i] = calcLinePoint(t);
-            t+=precision;
+        if(tessellationMode!=TessellationMode::Uniform && points.size()>=2) {
+            const auto start = std::chrono::steady_clock::now();
+            lineValid = true;
+            incrementalMoves = 0;
+            if(tessellationMode==TessellationMode::Adaptive) {
+                calcAdaptiveLine();
+            }else {
+                calcArcLengthLine();
+            }
+            stats.vertexCount = linePoints.size();
+            stats.microseconds = std::chrono::duration<double,std::micro>(std::chrono::steady_clock::now()-start).count();
+            return;
+        }
+        linePoints.resize(sampleCount);
+        RecalculateLine(linePoints.data());
+    }
+    //uniform samples written to out, which has room for SampleCount() points
+    void RecalculateLine(glm::vec2* out) {
+        const auto start = std::chrono::steady_clock::now();
+        lineValid = true;
+        incrementalMoves = 0;
+        calcUniformLine(out,scalarBackend);
+        stats.vertexCount = sampleCount;
+        stats.microseconds = std::chrono::duration<double,std::micro>(std::chrono::steady_clock::now()-start).count();
+        if(errorTracking) {
+            stats.maxError = calcMaxError(out);
+        }
+    }
+    //moves one control point and applies B_k(t)*delta to the samples instead of recalculating them
+    DirtyRange MovePoint(const size_t index, const glm::vec2 pos) {
+        if(tessellationMode!=TessellationMode::Uniform || linePoints.size()!=sampleCount) {
+            SetPoint(index,pos);
+            RecalculateLine();
+            return {0,linePoints.size()};
+        }
+        return MovePoint(index,pos,linePoints.data());
+    }
+    //same for uniform samples kept outside linePoints
+    DirtyRange MovePoint(const size_t index, const glm::vec2 pos, glm::vec2* line) {
+        const glm::vec2 delta = pos-points[index];
+        points[index] = pos;
+        arcTableValid = false;
+        boundsValid = false;
+        //the float basis would undo what the other backends are for
+        if(points.size()<2 || !lineValid || incrementalMoves>=maxIncrementalMoves || scalarBackend!=ScalarBackend::Float) {
+            RecalculateLine(line);
+            return {0,sampleCount};
+        }
+        if(basisIndex!=index || basisPoints!=points.size() || basisPrecision!=precision || basisColumn.size()!=sampleCount) {
+            calcBasisColumn(index);
+        }
+        for(size_t j=basisRange.first;j<basisRange.first+basisRange.count;j++) {
+            line[j] += delta*basisColumn[j];
+        }
+        incrementalMoves++;
+        return basisRange;
+    }
+    //evaluates n values of t at once, SIMD for curves up to maxBatchPoints points
+    void EvaluateBatch(const float* ts, const size_t n, glm::vec2* out) {
+        if(points.size()<2) {
+            std::fill(out,out+n,glm::vec2(0,0));
+            return;
         }
+        if(points.size()>maxBernsteinPoints) {
+            for(size_t i=0;i<n;i++) {
+                out[i] = calcLinePoint(ts[i]);
+            }
+            return;
+        }
+        calcWeights();
+        if(points.size()>maxBatchPoints) {
+            for(size_t i=0;i<n;i++) {
+                out[i] = glm::vec2(calcBernsteinPoint(ts[i]));
+            }
+            return;
+        }
+        calcBatchWeights();
+        BezierBatch::Evaluate(batchWeightsX.data(),batchWeightsY.data(),batchWeightsX.size(),ts,n,out);
+    }
+    //exact box of the curve, cached until the next edit
+    const BoundingBox& Bounds() {
+        if(!boundsValid) {
+            calcBounds();
+        }
+        return bounds;
+    }
+    //length of the whole curve, from the arc length table like the queries below
+    float Length() {
+        if(!arcTableValid) {
+            calcArcTable();
+        }
+        return arcLengths.back();
+    }
+    //arc length from the start to t, O(1)
+    float LengthAt(const float t) {
+        if(!arcTableValid) {
+            calcArcTable();
+        }
+        const size_t segments = arcLengths.size()-1;
+        const float x = std::clamp(t,0.0f,1.0f)*static_cast<float>(segments);
+        const size_t i = std::min(static_cast<size_t>(x),segments-1);
+        return arcLengths[i]+(arcLengths[i+1]-arcLengths[i])*(x-static_cast<float>(i));
+    }
+    //t at an arc length from the start, O(1) through the length buckets
+    float TAtLength(const float length) {
+        if(!arcTableValid) {
+            calcArcTable();
+        }
+        const size_t segments = arcLengths.size()-1;
+        if(length<=0.0f || arcLengths.back()<=0.0f) {
+            return 0.0f;
+        }
+        if(length>=arcLengths.back()) {
+            return 1.0f;
+        }
+        const float total = arcLengths.back();
+        size_t i = arcBuckets[std::min(static_cast<size_t>(length/total*static_cast<float>(segments)),segments)];
+        while(i+1<segments && arcLengths[i+1]<=length) {
+            i++;
+        }
+        const float chord = arcLengths[i+1]-arcLengths[i];
+        const float f = chord>0.0f ? (length-arcLengths[i])/chord : 0.0f;
+        return (static_cast<float>(i)+f)/static_cast<float>(segments);
+    }
+    //positions at n arc lengths, the lookups are done first so the evaluation runs batched
+    void EvaluateAtLengths(const float* lengths, const size_t n, glm::vec2* out) {
+        arcQueryTs.resize(n);
+        for(size_t i=0;i<n;i++) {
+            arcQueryTs[i] = TAtLength(lengths[i]);
+        }
+        EvaluateBatch(arcQueryTs.data(),n,out);
+    }
+    //evaluates a single point with the de Casteljau algorithm, for accuracy comparisons
+    glm::vec2 EvaluateReference(const float t) {
+        return calcLinePoint(t);
+    }
+    void SetEvaluationMode(const EvaluationMode mode) {
+        evaluationMode = mode;
+    }
+    EvaluationMode GetEvaluationMode() const {
+        return evaluationMode;
+    }
+    //the mode float uniform samples are calculated in, which differs from the set one where that one would be too slow or inaccurate
+    EvaluationMode EffectiveEvaluationMode() const {
+        if(points.size()>maxBernsteinPoints) {
+            return EvaluationMode::DeCasteljau;
+        }
+        if(evaluationMode==EvaluationMode::ForwardDifference && points.size()>=2 && calcForwardDifferenceInterval()==0) {
+            return EvaluationMode::Bernstein;
+        }
+        return evaluationMode;
+    }
+    void SetScalarBackend(const ScalarBackend backend) {
+        scalarBackend = backend;
+        lineValid = false;
+    }
+    ScalarBackend GetScalarBackend() const {
+        return scalarBackend;
+    }
+    //stats.maxError after every uniform RecalculateLine, at the cost of a de Casteljau evaluation in double per sample
+    void SetErrorTracking(const bool tracking) {
+        errorTracking = tracking;
+        stats.maxError = 0.0f;
+    }
+    bool GetErrorTracking() const {
+        return errorTracking;
+    }
+    //max distance of the uniform samples of a backend from the double reference, linePoints is left alone
+    float MaxError(const ScalarBackend backend) {
+        backendLine.resize(sampleCount);
+        calcUniformLine(backendLine.data(),backend);
+        return calcMaxError(backendLine.data());
+    }
+    //the backend that tessellates this curve the fastest on this machine while staying within tolerance, Double when none does
+    ScalarBackend FastestBackend(const float tolerance, const int repeats = 3) {
+        ScalarBackend fastest = ScalarBackend::Double;
+        double fastestTime = 0.0;
+        backendLine.resize(sampleCount);
+        for(const ScalarBackend backend : {ScalarBackend::Float,ScalarBackend::Double,ScalarBackend::Fixed}) {
+            double time = 0.0;
+            for(int i=0;i<repeats;i++) {
+                const auto start = std::chrono::steady_clock::now();
+                calcUniformLine(backendLine.data(),backend);
+                const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+                time = i==0 ? elapsed : std::min(time,elapsed);
+            }
+            if(calcMaxError(backendLine.data())<=tolerance && (fastestTime==0.0 || time<fastestTime)) {
+                fastest = backend;
+                fastestTime = time;
+            }
+        }
+        return fastest;
     }
     void SetPrecision(const float p){
         precision = p;
-        linePoints.clear();
-        linePoints.resize(1.0f/precision+1);
+        calcSampleCount();
+        lineValid = false;
     }
     float GetPrecision() const {
         return precision;
     }
-};
\ No newline at end of file
+    //vertex count of the uniform tessellation
+    size_t SampleCount() const {
+        return sampleCount;
+    }
+    void SetTessellationMode(const TessellationMode mode) {
+        tessellationMode = mode;
+        lineValid = false;
+    }
+    TessellationMode GetTessellationMode() const {
+        return tessellationMode;
+    }
+    //max distance in pixels between the adaptive line and the curve
+    void SetFlatnessTolerance(const float tolerance) {
+        flatnessTolerance = tolerance;
+    }
+    float GetFlatnessTolerance() const {
+        return flatnessTolerance;
+    }
+    //vertex count and duration of the last RecalculateLine
+    const TessellationStats& GetStats() const {
+        return stats;
+    }
+};
@@ -0,0 +1,345 @@
+#pragma once
+
+#include "BezierBatch.h"
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <utility>
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <type_traits>
+
+//scalar of a point type, the type itself for float and double and the component type for vectors
+template<class Vec, class = void>
+struct BezierScalar {
+    using type = std::decay_t<decltype(std::declval<const Vec&>()[0])>;
+};
+template<class Vec>
+struct BezierScalar<Vec,std::enable_if_t<std::is_arithmetic<Vec>::value>> {
+    using type = Vec;
+};
+
+//number of scalars in a point type, glm vectors are laid out as plain arrays of them like glm::value_ptr assumes
+template<class Vec>
+struct BezierComponents {
+    static constexpr size_t count = sizeof(Vec)/sizeof(typename BezierScalar<Vec>::type);
+};
+
+//curve of a degree fixed at compile time, the points live in a std::array and evaluation is unrolled over them
+//a literal type, so a curve of float or double points can be evaluated in constant expressions
+//the samples go to a buffer of the caller's, Vec can be float, double or any glm vector
+template<size_t Degree, class Vec = glm::vec2>
+class BezierCurveN {
+    static_assert(Degree>=1,"a curve needs at least two points");
+public:
+    using Scalar = typename BezierScalar<Vec>::type;
+    static constexpr size_t degree = Degree;
+    static constexpr size_t pointCount = Degree+1;
+    static constexpr size_t components = BezierComponents<Vec>::count;
+    //bound on the distance of forward difference samples from the curve, in units of the points
+    static constexpr double forwardDifferenceTolerance = 4e-3;
+    static constexpr Scalar Binomial(const size_t n, const size_t k) {
+        Scalar binomial = 1;
+        for(size_t i=0;i<k;i++) {
+            binomial = binomial*static_cast<Scalar>(n-i)/static_cast<Scalar>(i+1);
+        }
+        return binomial;
+    }
+private:
+    template<size_t... I>
+    static constexpr std::array<Scalar,pointCount> calcBinomials(std::index_sequence<I...>) {
+        return {Binomial(Degree,I)...};
+    }
+    //n*C(n-1,i), the weights of the point differences in the derivative
+    template<size_t... I>
+    static constexpr std::array<Scalar,Degree> calcDerivativeWeights(std::index_sequence<I...>) {
+        return {(static_cast<Scalar>(Degree)*Binomial(Degree-1,I))...};
+    }
+    static constexpr std::array<Scalar,pointCount> calcPowers(const Scalar x) {
+        std::array<Scalar,pointCount> powers{};
+        powers[0] = 1;
+        for(size_t i=1;i<pointCount;i++) {
+            powers[i] = powers[i-1]*x;
+        }
+        return powers;
+    }
+    //sum of C(n,i) t^i (1-t)^(n-i) p_i as one expression, nothing is left to a loop
+    template<size_t... I>
+    constexpr Vec calcPoint(const Scalar t, std::index_sequence<I...>) const {
+        const std::array<Scalar,pointCount> tPowers = calcPowers(t);
+        const std::array<Scalar,pointCount> sPowers = calcPowers(Scalar(1)-t);
+        return ((points[I]*(binomials[I]*tPowers[I]*sPowers[Degree-I])) + ...);
+    }
+    template<size_t... I>
+    constexpr Vec calcDerivative(const Scalar t, std::index_sequence<I...>) const {
+        const std::array<Scalar,pointCount> tPowers = calcPowers(t);
+        const std::array<Scalar,pointCount> sPowers = calcPowers(Scalar(1)-t);
+        return (((points[I+1]-points[I])*(derivativeWeights[I]*tPowers[I]*sPowers[Degree-1-I])) + ...);
+    }
+    //a_j = sum w[j][i] p_i are the monomial coefficients, w[j][i] = C(n,j) (-1)^(j-i) C(j,i)
+    static constexpr std::array<std::array<double,pointCount>,pointCount> calcPowerWeights() {
+        std::array<std::array<double,pointCount>,pointCount> weights{};
+        for(size_t j=0;j<pointCount;j++) {
+            for(size_t i=0;i<=j;i++) {
+                weights[j][i] = ((j-i)%2 ? -1.0 : 1.0)*BezierCurveN<Degree,double>::Binomial(j,i)*BezierCurveN<Degree,double>::Binomial(Degree,j);
+            }
+        }
+        return weights;
+    }
+    static constexpr std::array<std::array<double,pointCount>,pointCount> powerWeights = calcPowerWeights();
+    //coefficient j of every component next to each other, so the components are evaluated together
+    std::array<std::array<double,components>,pointCount> calcPowerCoefficients() const {
+        std::array<std::array<double,components>,pointCount> coefficients{};
+        for(size_t j=0;j<pointCount;j++) {
+            for(size_t i=0;i<=j;i++) {
+                const Scalar* point = reinterpret_cast<const Scalar*>(&points[i]);
+                for(size_t k=0;k<components;k++) {
+                    coefficients[j][k] += powerWeights[j][i]*static_cast<double>(point[k]);
+                }
+            }
+        }
+        return coefficients;
+    }
+    static void calcHorner(const std::array<std::array<double,components>,pointCount>& coefficients, const double t, double (&value)[components]) {
+        for(size_t k=0;k<components;k++) {
+            value[k] = coefficients[Degree][k];
+        }
+        for(size_t j=Degree;j-->0;) {
+            for(size_t k=0;k<components;k++) {
+                value[k] = value[k]*t+coefficients[j][k];
+            }
+        }
+    }
+    //lanes of consecutive samples that step forward together, as many as make the blocks a multiple of 32 scalars
+    static constexpr size_t lanes = 32/std::gcd(size_t(32),components);
+    //steps a lane can take between reseeds, 8 to 256 at powers of two and halfway between them
+    static constexpr size_t reseedChoices = 11;
+    static constexpr std::array<size_t,reseedChoices> calcReseedSteps() {
+        std::array<size_t,reseedChoices> steps{};
+        for(size_t c=0;c<reseedChoices;c++) {
+            steps[c] = (size_t(8)<<(c/2))*(c%2 ? 3 : 2)/2;
+        }
+        return steps;
+    }
+    static constexpr std::array<size_t,reseedChoices> reseedSteps = calcReseedSteps();
+    //C(k,m)+C(k,m+1) for those steps k, by m so the choices are summed together
+    static constexpr std::array<std::array<double,reseedChoices>,pointCount> calcReseedGrowth() {
+        std::array<std::array<double,reseedChoices>,pointCount> growth{};
+        for(size_t m=0;m<pointCount;m++) {
+            for(size_t c=0;c<reseedChoices;c++) {
+                growth[m][c] = BezierCurveN<Degree,double>::Binomial(reseedSteps[c],m)+BezierCurveN<Degree,double>::Binomial(reseedSteps[c],m+1);
+            }
+        }
+        return growth;
+    }
+    static constexpr std::array<std::array<double,reseedChoices>,pointCount> reseedGrowth = calcReseedGrowth();
+    //scalars of a block of lanes samples
+    static constexpr size_t width = lanes*components;
+    //around sample i the curve is sum c_r h^r u^r with h the step and u the samples from i, so the m-th difference with
+    //a step of lanes samples at i+l is sum w[m][r][l] c_r h^r, w[m][r][l] = sum_q (-1)^(m-q) C(m,q) (l+q*lanes)^r, 0 for r<m
+    //the lanes are spread out to the scalars of a block like the samples are so the sums run over whole blocks
+    static constexpr std::array<std::array<std::array<double,width>,pointCount>,pointCount> calcSeedWeights() {
+        std::array<std::array<std::array<double,width>,pointCount>,pointCount> weights{};
+        for(size_t m=0;m<pointCount;m++) {
+            for(size_t r=m;r<pointCount;r++) {
+                for(size_t l=0;l<lanes;l++) {
+                    double weight = 0.0;
+                    for(size_t q=0;q<=m;q++) {
+                        double power = 1.0;
+                        for(size_t e=0;e<r;e++) {
+                            power *= static_cast<double>(l+q*lanes);
+                        }
+                        weight += ((m-q)%2 ? -1.0 : 1.0)*BezierCurveN<Degree,double>::Binomial(m,q)*power;
+                    }
+                    for(size_t k=0;k<components;k++) {
+                        weights[m][r][l*components+k] = weight;
+                    }
+                }
+            }
+        }
+        return weights;
+    }
+    static constexpr std::array<std::array<std::array<double,width>,pointCount>,pointCount> seedWeights = calcSeedWeights();
+    //difference m of a lane is within b_m = H^m n!/(n-m)! max|m-th difference of the points|, its rounding and the rounding
+    //of every add into it reach the samples k steps later multiplied by C(k,m) and C(k,m+1)
+    //steps between reseeds for all of that to stay within forwardDifferenceTolerance, the fewest there are to choose from if none does
+    size_t calcReseedInterval(const double laneStep) const {
+        //in double and per component, so the max over the points doesn't become one long chain of dependent instructions
+        double d[pointCount][components];
+        for(size_t i=0;i<pointCount;i++) {
+            const Scalar* point = reinterpret_cast<const Scalar*>(&points[i]);
+            for(size_t k=0;k<components;k++) {
+                d[i][k] = static_cast<double>(point[k]);
+            }
+        }
+        std::array<double,pointCount> bounds{};
+        double scale = 1.0;
+        for(size_t m=0;m<pointCount;m++) {
+            double magnitude[components] = {};
+            for(size_t i=0;i+m<pointCount;i++) {
+                for(size_t k=0;k<components;k++) {
+                    magnitude[k] = std::max(magnitude[k],std::abs(d[i][k]));
+                }
+            }
+            bounds[m] = scale**std::max_element(magnitude,magnitude+components);
+            for(size_t i=0;i+m+1<pointCount;i++) {
+                for(size_t k=0;k<components;k++) {
+                    d[i][k] = d[i+1][k]-d[i][k];
+                }
+            }
+            scale *= laneStep*static_cast<double>(Degree-m);
+        }
+        //the error grows with the steps, so the choices within the tolerance are the first ones
+        const double rounding = static_cast<double>(std::numeric_limits<Scalar>::epsilon())/2.0;
+        double errors[reseedChoices] = {};
+        for(size_t m=0;m<pointCount;m++) {
+            for(size_t c=0;c<reseedChoices;c++) {
+                errors[c] += bounds[m]*reseedGrowth[m][c];
+            }
+        }
+        size_t within = 0;
+        for(size_t c=0;c<reseedChoices;c++) {
+            within += errors[c]*rounding<=forwardDifferenceTolerance ? 1 : 0;
+        }
+        return reseedSteps[within>0 ? within-1 : 0];
+    }
+    static constexpr size_t calcSampleCount(const float precision) {
+        return static_cast<size_t>(1.0f/precision+1);
+    }
+    std::array<Vec,pointCount> points{};
+    float precision = 0.01f;
+    size_t sampleCount = calcSampleCount(0.01f);
+public:
+    static constexpr std::array<Scalar,pointCount> binomials = calcBinomials(std::make_index_sequence<pointCount>());
+    static constexpr std::array<Scalar,Degree> derivativeWeights = calcDerivativeWeights(std::make_index_sequence<Degree>());
+    constexpr BezierCurveN() = default;
+    constexpr explicit BezierCurveN(const std::array<Vec,pointCount>& points):points(points) {}
+    constexpr const std::array<Vec,pointCount>& Points() const {
+        return points;
+    }
+    constexpr void SetPoint(const size_t index, const Vec pos) {
+        points[index] = pos;
+    }
+    constexpr Vec Evaluate(const Scalar t) const {
+        return calcPoint(t,std::make_index_sequence<pointCount>());
+    }
+    //tangent, Degree times the curve of the point differences one degree lower
+    constexpr Vec Derivative(const Scalar t) const {
+        return calcDerivative(t,std::make_index_sequence<Degree>());
+    }
+    //de Casteljau, slower but the most accurate
+    constexpr Vec EvaluateReference(const Scalar t) const {
+        std::array<Vec,pointCount> p = points;
+        for(size_t c=pointCount;c>1;c--) {
+            for(size_t i=0;i+1<c;i++) {
+                p[i] = p[i]+(p[i+1]-p[i])*t;
+            }
+        }
+        return p[0];
+    }
+    void EvaluateBatch(const Scalar* ts, const size_t n, Vec* out) const {
+        for(size_t i=0;i<n;i++) {
+            out[i] = Evaluate(ts[i]);
+        }
+    }
+    //generic steps of blocks of lanes samples, adding every difference onto the one below it after each block
+    static void stepForward(Scalar (&differences)[pointCount][width], Vec* out, const size_t steps) {
+        for(size_t s=0;s<steps;s++) {
+            std::memcpy(out+s*lanes,differences[0],sizeof(differences[0]));
+            for(size_t m=0;m<Degree;m++) {
+                for(size_t e=0;e<width;e++) {
+                    differences[m][e] += differences[m+1][e];
+                }
+            }
+        }
+    }
+    //uniform samples written to out, which has room for SampleCount() points
+    //forward differences cost Degree adds per sample, lane l of a block takes the samples i+l with a step of lanes samples
+    //so the lanes are independent vector adds, and they are reseeded in double before their rounding adds up
+    //float curves step in BezierBatch, whose kernels follow the instruction set the batch evaluation is dispatched to
+    void RecalculateLine(Vec* out) const {
+        //locals, stores through out could alias the members otherwise
+        const std::array<std::array<double,components>,pointCount> coefficients = calcPowerCoefficients();
+        //the steps divide [0,1] evenly and the last sample is the end point itself, not an accumulation of steps
+        const size_t count = sampleCount>0 ? sampleCount-1 : 0;
+        const double step = count>0 ? 1.0/static_cast<double>(count) : 0.0;
+        const size_t interval = calcReseedInterval(step*static_cast<double>(lanes));
+        size_t i = 0;
+        while(i+lanes<=count) {
+            //coefficients around t_i scaled to the step, c_r h^r, in double and spread out like the seed weights
+            //differences of samples at i would cancel down to rounding noise at fine steps and high degrees
+            //the sample index goes through a signed integer, unsigned to double conversions are slow before AVX-512
+            const double t = static_cast<double>(static_cast<std::ptrdiff_t>(i))*step;
+            std::array<std::array<double,components>,pointCount> taylor = coefficients;
+            for(size_t r=0;r<Degree;r++) {
+                for(size_t j=Degree;j-->r;) {
+                    for(size_t k=0;k<components;k++) {
+                        taylor[j][k] += t*taylor[j+1][k];
+                    }
+                }
+            }
+            double scaled[pointCount][width];
+            double power = 1.0;
+            for(size_t r=0;r<pointCount;r++) {
+                for(size_t k=0;k<components;k++) {
+                    taylor[r][k] *= power;
+                }
+                for(size_t l=0;l<lanes;l++) {
+                    std::memcpy(scaled[r]+l*components,taylor[r].data(),sizeof(taylor[r]));
+                }
+                power *= step;
+            }
+            const size_t steps = std::min(interval,(count-i)/lanes);
+            if constexpr(std::is_same<Scalar,float>::value && pointCount<=BezierBatch::maxStepRows) {
+                BezierBatch::StepForward(&seedWeights[0][0][0],&scaled[0][0],pointCount,width,steps,reinterpret_cast<float*>(out+i));
+            }else {
+                //differences[m] is the m-th difference of a block of samples laid out like out, the 0th the samples themselves
+                Scalar differences[pointCount][width];
+                for(size_t m=0;m<pointCount;m++) {
+                    double sum[width] = {};
+                    for(size_t r=m;r<pointCount;r++) {
+                        for(size_t e=0;e<width;e++) {
+                            sum[e] += seedWeights[m][r][e]*scaled[r][e];
+                        }
+                    }
+                    for(size_t e=0;e<width;e++) {
+                        differences[m][e] = static_cast<Scalar>(sum[e]);
+                    }
+                }
+                stepForward(differences,out+i,steps);
+            }
+            i += steps*lanes;
+        }
+        for(;i<count;i++) {
+            double value[components];
+            calcHorner(coefficients,static_cast<double>(static_cast<std::ptrdiff_t>(i))*step,value);
+            Scalar* sample = reinterpret_cast<Scalar*>(out+i);
+            for(size_t k=0;k<components;k++) {
+                sample[k] = static_cast<Scalar>(value[k]);
+            }
+        }
+        if(sampleCount>0) {
+            out[count] = count>0 ? points[Degree] : points[0];
+        }
+    }
+    constexpr void SetPrecision(const float p) {
+        precision = p;
+        sampleCount = calcSampleCount(p);
+    }
+    constexpr float GetPrecision() const {
+        return precision;
+    }
+    constexpr size_t SampleCount() const {
+        return sampleCount;
+    }
+};
+
+static_assert(BezierCurveN<3,float>::binomials[1]==3.0f && BezierCurveN<4,double>::binomials[2]==6.0,"binomials are compile time constants");
+static_assert(BezierCurveN<2,double>(std::array<double,3>{0.0,2.0,6.0}).Evaluate(0.5)==2.5 &&
+              BezierCurveN<2,double>(std::array<double,3>{0.0,2.0,6.0}).Derivative(0.5)==6.0 &&
+              BezierCurveN<2,double>(std::array<double,3>{0.0,2.0,6.0}).EvaluateReference(0.5)==2.5,"curves evaluate in constant expressions");
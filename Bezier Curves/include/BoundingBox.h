@@ -0,0 +1,31 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cfloat>
+
+//axis aligned, the default one is empty and extending it by anything gives that thing's box
+struct BoundingBox {
+    glm::vec2 min{FLT_MAX};
+    glm::vec2 max{-FLT_MAX};
+    static BoundingBox Everything() {
+        return {glm::vec2(-FLT_MAX),glm::vec2(FLT_MAX)};
+    }
+    bool IsEmpty() const {
+        return min.x>max.x || min.y>max.y;
+    }
+    void Extend(const glm::vec2 p) {
+        min = glm::min(min,p);
+        max = glm::max(max,p);
+    }
+    void Extend(const BoundingBox& box) {
+        min = glm::min(min,box.min);
+        max = glm::max(max,box.max);
+    }
+    bool Intersects(const BoundingBox& box) const {
+        return min.x<=box.max.x && box.min.x<=max.x && min.y<=box.max.y && box.min.y<=max.y;
+    }
+    glm::vec2 Center() const {
+        return (min+max)*0.5f;
+    }
+};
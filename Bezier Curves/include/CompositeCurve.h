@@ -0,0 +1,135 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include "BezierCurve.h"
+
+#include <vector>
+#include <memory_resource>
+#include <cstdint>
+
+//piecewise curve made of cubic segments sharing their end points: points 0-3 are the first segment, 3-6 the second...
+//a move only re-tessellates the one or two segments containing the point, so the cost doesn't grow with the point count
+class CompositeCurve {
+public:
+    static constexpr size_t segmentDegree = 3;
+private:
+    //de Casteljau on at most segmentDegree+1 points, the last segment can have fewer
+    glm::vec2 calcSegmentPoint(const size_t segment, const float t) const {
+        const size_t first = segment*segmentDegree;
+        const size_t count = std::min(segmentDegree+1,points.size()-first);
+        glm::vec2 p[segmentDegree+1];
+        for(size_t i=0;i<count;i++) {
+            p[i] = points[first+i];
+        }
+        for(size_t c=count;c>1;c--) {
+            for(size_t i=0;i+1<c;i++) {
+                p[i] = Lerp(p[i],p[i+1],t);
+            }
+        }
+        return p[0];
+    }
+    //samples of segment s are at 1+s*samplesPerSegment, linePoints[0] is the start of the whole curve
+    void tessellateSegment(const size_t segment) {
+        glm::vec2* out = linePoints.data()+1+segment*samplesPerSegment;
+        for(size_t j=0;j<samplesPerSegment;j++) {
+            out[j] = calcSegmentPoint(segment,static_cast<float>(j+1)/static_cast<float>(samplesPerSegment));
+        }
+        segmentDirty[segment] = 0;
+    }
+    void calcLayout() {
+        layoutPoints = points.size();
+        const size_t segments = SegmentCount();
+        segmentDirty.assign(segments,1);
+        dirtyFirst = 0;
+        dirtyEnd = segments;
+        linePoints.resize(segments>0 ? 1+segments*samplesPerSegment : 0);
+    }
+    std::pmr::memory_resource* memoryResource;
+    float precision = 0.05f;
+    size_t samplesPerSegment = 20;
+    //point count the segment layout was made for
+    size_t layoutPoints = 0;
+    std::pmr::vector<uint8_t> segmentDirty{memoryResource};
+    //segments outside [dirtyFirst,dirtyEnd) are clean, so a move doesn't scan all flags
+    size_t dirtyFirst = 0;
+    size_t dirtyEnd = 0;
+    void markSegmentDirty(const size_t segment) {
+        segmentDirty[segment] = 1;
+        dirtyFirst = std::min(dirtyFirst,segment);
+        dirtyEnd = std::max(dirtyEnd,segment+1);
+    }
+public:
+    std::pmr::vector<glm::vec2> points{memoryResource};
+    std::pmr::vector<glm::vec2> linePoints{memoryResource};
+    //points, line and segment flags allocate from resource, like BezierCurve's
+    explicit CompositeCurve(std::pmr::memory_resource* resource = std::pmr::get_default_resource()):memoryResource(resource) {}
+    std::pmr::memory_resource* GetMemoryResource() const {
+        return memoryResource;
+    }
+    size_t SegmentCount() const {
+        return points.size()<2 ? 0 : (points.size()-1+segmentDegree-1)/segmentDegree;
+    }
+    //needed after points are added or erased directly
+    void MarkAllDirty() {
+        std::fill(segmentDirty.begin(),segmentDirty.end(),1);
+        dirtyFirst = 0;
+        dirtyEnd = segmentDirty.size();
+    }
+    void MarkPointDirty(const size_t index) {
+        if(layoutPoints!=points.size()) {
+            return; //the whole layout is redone anyway
+        }
+        const size_t segment = index/segmentDegree;
+        if(segment<segmentDirty.size()) {
+            markSegmentDirty(segment);
+        }
+        if(index%segmentDegree==0 && segment>0) { //shared end point of the previous segment
+            markSegmentDirty(segment-1);
+        }
+    }
+    //re-tessellates dirty segments only, dirty segments of a single move are adjacent so one range covers them
+    BezierCurve::DirtyRange RecalculateDirty() {
+        if(layoutPoints!=points.size()) {
+            calcLayout();
+        }
+        BezierCurve::DirtyRange range{linePoints.size(),0};
+        for(size_t s=dirtyFirst;s<dirtyEnd;s++) {
+            if(!segmentDirty[s]) {
+                continue;
+            }
+            if(s==0) {
+                linePoints[0] = points[0];
+            }
+            tessellateSegment(s);
+            const size_t first = s==0 ? 0 : 1+s*samplesPerSegment;
+            const size_t last = 1+(s+1)*samplesPerSegment;
+            range.first = std::min(range.first,first);
+            range.count = last-range.first;
+        }
+        if(range.count==0) {
+            range.first = 0;
+        }
+        dirtyFirst = segmentDirty.size();
+        dirtyEnd = 0;
+        return range;
+    }
+    BezierCurve::DirtyRange MovePoint(const size_t index, const glm::vec2 pos) {
+        points[index] = pos;
+        MarkPointDirty(index);
+        return RecalculateDirty();
+    }
+    void RecalculateLine() {
+        calcLayout();
+        RecalculateDirty();
+    }
+    //t step inside each segment
+    void SetPrecision(const float p) {
+        precision = p;
+        samplesPerSegment = std::max<size_t>(1,static_cast<size_t>(1.0f/precision));
+        layoutPoints = 0;
+    }
+    float GetPrecision() const {
+        return precision;
+    }
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <memory_resource>
+#include <atomic>
+#include <cstddef>
+
+//passes everything to an upstream resource and counts it, to check that steady state edits don't allocate
+class CountingResource : public std::pmr::memory_resource {
+public:
+    explicit CountingResource(std::pmr::memory_resource* upstream = std::pmr::get_default_resource()):upstream(upstream) {}
+    size_t Allocations() const {
+        return allocations.load(std::memory_order_relaxed);
+    }
+    size_t Deallocations() const {
+        return deallocations.load(std::memory_order_relaxed);
+    }
+    size_t BytesAllocated() const {
+        return bytes.load(std::memory_order_relaxed);
+    }
+    void Reset() {
+        allocations = 0;
+        deallocations = 0;
+        bytes = 0;
+    }
+private:
+    void* do_allocate(const size_t size, const size_t alignment) override {
+        allocations.fetch_add(1,std::memory_order_relaxed);
+        bytes.fetch_add(size,std::memory_order_relaxed);
+        return upstream->allocate(size,alignment);
+    }
+    void do_deallocate(void* p, const size_t size, const size_t alignment) override {
+        deallocations.fetch_add(1,std::memory_order_relaxed);
+        upstream->deallocate(p,size,alignment);
+    }
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this==&other;
+    }
+    std::pmr::memory_resource* upstream;
+    std::atomic<size_t> allocations{0};
+    std::atomic<size_t> deallocations{0};
+    std::atomic<size_t> bytes{0};
+};
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include "BoundingBox.h"
+#include "ThreadPool.h"
+
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+//closest points and intersections for batches of queries against a fixed set of curves
+//every curve is split once by de Casteljau into a tree of pieces, down to leaves whose control polygon is within tolerance of its chord
+//a piece lies in the box of its control polygon, so whole subtrees are pruned by box distance or box overlap
+//leaves are solved on their chord first and then polished with Newton steps on the piece itself
+class CurveQuery {
+public:
+	//one entry per query
+	struct ClosestPointResults {
+		std::vector<float> t;
+		std::vector<float> x;
+		std::vector<float> y;
+		std::vector<float> distance;
+	};
+	//the hits of pair i are first[i] to first[i]+count[i] in the other arrays, sorted by tA
+	struct IntersectionResults {
+		std::vector<uint32_t> first;
+		std::vector<uint32_t> count;
+		std::vector<float> tA;
+		std::vector<float> tB;
+		std::vector<float> x;
+		std::vector<float> y;
+	};
+	//queries per pool task
+	static constexpr size_t batchSize = 1024;
+	//at most 2^maxDepth leaves per curve, also where curves too wiggly for the tolerance stop splitting
+	static constexpr int maxDepth = 12;
+	static constexpr int newtonIterations = 4;
+
+	//tolerance is in the units of the points, answers are refined well below it
+	explicit CurveQuery(float tolerance = 0.1f);
+	//returns the curve's index for the queries, curves with less than two points never intersect anything
+	size_t AddCurve(const glm::vec2* points, size_t count);
+	void Clear();
+	size_t CurveCount() const;
+	size_t NodeCount() const;
+	float Tolerance() const;
+
+	//for every i the point of curve curves[i] nearest to points[i], the pool spreads the batch over its workers
+	void ClosestPoints(const uint32_t* curves, const glm::vec2* points, size_t n, ClosestPointResults& out, ThreadPool* pool = nullptr) const;
+	//every intersection of curve curvesA[i] with curve curvesB[i], a curve with itself has none
+	void Intersect(const uint32_t* curvesA, const uint32_t* curvesB, size_t n, IntersectionResults& out, ThreadPool* pool = nullptr) const;
+private:
+	struct Node {
+		BoundingBox box;
+		float t0 = 0.0f;
+		float t1 = 1.0f;
+		//first of the two children, which are next to each other, or -1 for a leaf
+		int32_t children = -1;
+		//a leaf's control points in leafPoints
+		uint32_t points = 0;
+		//leaves at maxDepth may be less flat than the tolerance
+		bool flat = false;
+	};
+	struct Curve {
+		uint32_t root = 0;
+		uint32_t pointCount = 0;
+	};
+	//what one task needs for its evaluations
+	struct Scratch {
+		std::vector<glm::vec2> points;
+		std::vector<uint32_t> stack;
+		std::vector<uint32_t> pairStack;
+	};
+	struct Hit {
+		float tA;
+		float tB;
+		glm::vec2 pos;
+	};
+
+	bool isFlat(const glm::vec2* p, size_t count) const;
+	void build(uint32_t node, std::vector<glm::vec2>& p, float t0, float t1, int depth);
+	//position and first two derivatives of a piece at u, by de Casteljau down to the last three points
+	static void evaluate(const glm::vec2* p, size_t count, float u, glm::vec2& pos, glm::vec2& d1, glm::vec2& d2, std::vector<glm::vec2>& scratch);
+	void closestPoint(const Curve& curve, glm::vec2 q, Scratch& scratch, float& t, glm::vec2& pos, float& distance) const;
+	void refineLeaf(const Curve& curve, const Node& leaf, glm::vec2 q, Scratch& scratch, float& best, float& t, glm::vec2& pos) const;
+	void intersect(const Curve& a, const Curve& b, Scratch& scratch, std::vector<Hit>& hits) const;
+	void intersectLeaves(const Curve& a, const Node& leafA, const Curve& b, const Node& leafB, Scratch& scratch, std::vector<Hit>& hits) const;
+	//runs task over [first,first+count) ranges of n, on the pool when there is one
+	static void forBatches(size_t n, ThreadPool* pool, const std::function<void(size_t,size_t,size_t)>& task);
+
+	float tolerance;
+	std::vector<Node> nodes;
+	std::vector<glm::vec2> leafPoints;
+	std::vector<Curve> curves;
+};
@@ -0,0 +1,423 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include "BezierCurve.h"
+#include "BoundingBox.h"
+#include "BVH.h"
+#include "ThreadPool.h"
+
+#include <vector>
+#include <memory_resource>
+#include <cstdint>
+#include <chrono>
+#include <algorithm>
+
+//many curves whose lines and control points live in slices of two shared arenas, ready for a single upload each
+//dirty curves are re-tessellated on a ThreadPool straight into their slice
+//curves outside the view are culled by a BVH over their exact boxes, the lines of visible ones by boxes of fixed size chunks
+//a line's slice holds levels of detail after it, each with every other vertex of the one before, the view picks one per curve
+class CurveScene {
+public:
+    //line vertices per culling chunk, neighbouring chunks share their end vertex
+    static constexpr size_t chunkVertices = 64;
+    static constexpr size_t maxLodLevels = 8;
+    //coarser levels are only kept while they have at least this many segments
+    static constexpr size_t minLodSegments = 4;
+    //a curve gets the coarsest level with a segment per this many pixels of its extent
+    static constexpr float lodPixelsPerSegment = 4.0f;
+    //vertices of a level, vertex j of it is vertex min(j<<level,count-1) of the line
+    static size_t LodCount(const size_t count, const size_t level) {
+        return count<2 ? count : ((count-2)>>level)+2;
+    }
+    static size_t LodLevels(const size_t count) {
+        size_t levels = 1;
+        while(levels<maxLodLevels && count>=2 && LodCount(count,levels)-1>=minLodSegments) {
+            levels++;
+        }
+        return levels;
+    }
+    //vertices of all levels of a line together
+    static size_t LodTotal(const size_t count) {
+        size_t total = 0;
+        for(size_t level=0;level<LodLevels(count);level++) {
+            total += LodCount(count,level);
+        }
+        return total;
+    }
+    struct Slice {
+        size_t first = 0;
+        size_t count = 0;
+    };
+    //what changed in the arenas since the last update, resized means everything
+    struct Update {
+        BezierCurve::DirtyRange lines;
+        BezierCurve::DirtyRange points;
+        bool resized = false;
+    };
+private:
+    static void merge(BezierCurve::DirtyRange& range, const size_t first, const size_t count) {
+        if(count==0) {
+            return;
+        }
+        if(range.count==0) {
+            range = {first,count};
+            return;
+        }
+        const size_t end = std::max(range.first+range.count,first+count);
+        range.first = std::min(range.first,first);
+        range.count = end-range.first;
+    }
+    size_t lineCount(const size_t curve) const {
+        const BezierCurve& c = curves[curve];
+        if(c.Points().size()<2 || c.Points().size()<minLinePoints) {
+            return 0;
+        }
+        return c.GetTessellationMode()==BezierCurve::TessellationMode::Uniform ? c.SampleCount() : c.linePoints.size();
+    }
+    //new slices when any count changed, lines of clean curves are carried over from the old arena
+    bool calcLayout() {
+        bool changed = false;
+        for(size_t i=0;i<curves.size() && !changed;i++) {
+            changed = lineSlices[i].count!=lineCount(i) || pointSlices[i].count!=curves[i].Points().size();
+        }
+        if(!changed) {
+            return false;
+        }
+        size_t lineTotal = 0;
+        size_t pointTotal = 0;
+        for(size_t i=0;i<curves.size();i++) {
+            lineTotal += LodTotal(lineCount(i));
+            pointTotal += curves[i].Points().size();
+        }
+        spareVertices.resize(lineTotal);
+        lineTotal = 0;
+        pointTotal = 0;
+        for(size_t i=0;i<curves.size();i++) {
+            const Slice old = lineSlices[i];
+            lineSlices[i] = {lineTotal,lineCount(i)};
+            pointSlices[i] = {pointTotal,curves[i].Points().size()};
+            if(!dirty[i] && old.count==lineSlices[i].count) {
+                std::copy(vertices.begin()+old.first,vertices.begin()+old.first+LodTotal(old.count),spareVertices.begin()+lineTotal);
+            }else {
+                dirty[i] = 1;
+            }
+            lineTotal += LodTotal(lineSlices[i].count);
+            pointTotal += pointSlices[i].count;
+        }
+        vertices.swap(spareVertices);
+        size_t chunkTotal = 0;
+        for(size_t i=0;i<curves.size();i++) {
+            const size_t count = lineSlices[i].count;
+            chunkSlices[i] = {chunkTotal,count>=2 ? (count-2)/chunkVertices+1 : 0};
+            chunkTotal += chunkSlices[i].count;
+        }
+        chunkBoxes.resize(chunkTotal);
+        for(size_t i=0;i<curves.size();i++) {
+            if(!dirty[i]) {
+                calcChunkBoxes(i,0,lineSlices[i].count);
+            }
+        }
+        controlPoints.resize(pointTotal);
+        for(size_t i=0;i<curves.size();i++) {
+            std::copy(curves[i].Points().begin(),curves[i].Points().end(),controlPoints.begin()+pointSlices[i].first);
+        }
+        return true;
+    }
+    //boxes of the chunks that contain any of the vertices first..first+count of the curve's line
+    void calcChunkBoxes(const size_t curve, const size_t first, const size_t count) {
+        const Slice& line = lineSlices[curve];
+        const Slice& chunks = chunkSlices[curve];
+        if(chunks.count==0 || count==0) {
+            return;
+        }
+        const size_t firstChunk = first>0 ? (first-1)/chunkVertices : 0;
+        const size_t lastChunk = std::min((first+count-1)/chunkVertices,chunks.count-1);
+        for(size_t k=firstChunk;k<=lastChunk;k++) {
+            BoundingBox box;
+            const size_t last = std::min((k+1)*chunkVertices,line.count-1);
+            for(size_t v=k*chunkVertices;v<=last;v++) {
+                box.Extend(vertices[line.first+v]);
+            }
+            chunkBoxes[chunks.first+k] = box;
+        }
+    }
+    //coarser levels from the vertices first..first+count of the finest one
+    void calcLods(const size_t curve, const size_t first, const size_t count) {
+        const Slice& line = lineSlices[curve];
+        if(count==0) {
+            return;
+        }
+        const size_t last = first+count-1;
+        size_t offset = line.first+line.count;
+        for(size_t level=1;level<LodLevels(line.count);level++) {
+            const size_t lodCount = LodCount(line.count,level);
+            const size_t end = std::min((last>>level)+1,lodCount-1);
+            for(size_t j=first>>level;j<=end;j++) {
+                vertices[offset+j] = vertices[line.first+std::min(j<<level,line.count-1)];
+            }
+            offset += lodCount;
+        }
+    }
+    //coarsest level that still has a segment per lodPixelsPerSegment of the curve's extent on screen
+    size_t chooseLod(const size_t curve, const size_t count) const {
+        const glm::vec2 size = (curveBoxes[curve].max-curveBoxes[curve].min)*pixelsPerUnit;
+        const float segments = std::max(size.x,size.y)/lodPixelsPerSegment;
+        size_t level = 0;
+        while(level+1<LodLevels(count) && static_cast<float>(LodCount(count,level+1)-1)>=segments) {
+            level++;
+        }
+        return level;
+    }
+    //boxes of edited curves, the tree is rebuilt when curves were added and refitted otherwise
+    void refreshBounds() {
+        if(curveTree.Size()!=curves.size()) {
+            for(size_t i=0;i<curves.size();i++) {
+                curveBoxes[i] = curves[i].Bounds();
+                boundsDirty[i] = 0;
+            }
+            curveTree.Build(curveBoxes.data(),curveBoxes.size());
+            return;
+        }
+        bool changed = false;
+        for(size_t i=0;i<curves.size();i++) {
+            if(boundsDirty[i]) {
+                curveBoxes[i] = curves[i].Bounds();
+                boundsDirty[i] = 0;
+                changed = true;
+            }
+        }
+        if(changed) {
+            curveTree.Refit(curveBoxes.data());
+        }
+    }
+    bool inView(const size_t curve) const {
+        return curveBoxes[curve].Intersects(view);
+    }
+    void tessellate(const size_t curve) {
+        BezierCurve& c = curves[curve];
+        lineRevisions[curve]++;
+        const Slice& line = lineSlices[curve];
+        if(line.count>0) {
+            if(c.GetTessellationMode()==BezierCurve::TessellationMode::Uniform) {
+                c.RecalculateLine(vertices.data()+line.first);
+            }else {
+                std::copy(c.linePoints.begin(),c.linePoints.end(),vertices.begin()+line.first);
+            }
+            calcChunkBoxes(curve,0,line.count);
+            calcLods(curve,0,line.count);
+        }
+        copyPoints(curve);
+    }
+    void copyPoints(const size_t curve) {
+        std::copy(curves[curve].Points().begin(),curves[curve].Points().end(),controlPoints.begin()+pointSlices[curve].first);
+    }
+    std::pmr::memory_resource* memoryResource;
+    std::pmr::vector<uint8_t> dirty{memoryResource};
+    std::pmr::vector<Slice> lineSlices{memoryResource};
+    std::pmr::vector<Slice> pointSlices{memoryResource};
+    std::pmr::vector<uint32_t> lineRevisions{memoryResource};
+    std::pmr::vector<uint8_t> boundsDirty{memoryResource};
+    std::pmr::vector<BoundingBox> curveBoxes{memoryResource};
+    BVH curveTree{memoryResource};
+    std::pmr::vector<Slice> chunkSlices{memoryResource};
+    std::pmr::vector<BoundingBox> chunkBoxes{memoryResource};
+    BoundingBox view = BoundingBox::Everything();
+    float pixelsPerUnit = 1.0f;
+    std::pmr::vector<uint8_t> lods{memoryResource};
+    std::pmr::vector<uint32_t> visibleCurves{memoryResource};
+    std::pmr::vector<Slice> visibleLines{memoryResource};
+    //two vertex arenas swapped on layout changes, their capacity is kept
+    std::pmr::vector<glm::vec2> vertices{memoryResource};
+    std::pmr::vector<glm::vec2> spareVertices{memoryResource};
+    std::pmr::vector<glm::vec2> controlPoints{memoryResource};
+    size_t minLinePoints = 0;
+    Update pending;
+    std::chrono::steady_clock::time_point tessellationStart;
+    double tessellationMicroseconds = 0.0;
+public:
+    //don't add curves or edit them between BeginTessellation and FinishTessellation
+    std::pmr::vector<BezierCurve> curves{memoryResource};
+    //curves and arenas allocate from resource
+    explicit CurveScene(std::pmr::memory_resource* resource = std::pmr::get_default_resource()):memoryResource(resource) {}
+    size_t AddCurve() {
+        curves.emplace_back(memoryResource);
+        dirty.push_back(1);
+        lineSlices.emplace_back();
+        pointSlices.emplace_back();
+        lineRevisions.push_back(0);
+        boundsDirty.push_back(1);
+        curveBoxes.emplace_back();
+        chunkSlices.emplace_back();
+        lods.push_back(0);
+        return curves.size()-1;
+    }
+    void MarkDirty(const size_t curve) {
+        dirty[curve] = 1;
+        boundsDirty[curve] = 1;
+    }
+    void MarkAllDirty() {
+        std::fill(dirty.begin(),dirty.end(),1);
+        std::fill(boundsDirty.begin(),boundsDirty.end(),1);
+    }
+    //world space box that is drawn, dirty curves outside of it are not tessellated until they come into view
+    //the levels of detail are picked for pixelsPerUnit, zooming only switches between them
+    void SetView(const BoundingBox& box, const float pixels = 1.0f) {
+        view = box;
+        pixelsPerUnit = pixels;
+    }
+    const BoundingBox& View() const {
+        return view;
+    }
+    //curves with fewer control points get no line vertices, something else draws them from the control points
+    void SetMinLinePoints(const size_t points) {
+        if(points!=minLinePoints) {
+            minLinePoints = points;
+            MarkAllDirty();
+        }
+    }
+    size_t GetMinLinePoints() const {
+        return minLinePoints;
+    }
+    //incremental update of a uniform curve right away, anything else is left to the next tessellation
+    Update MovePoint(const size_t curve, const size_t index, const glm::vec2 pos) {
+        BezierCurve& c = curves[curve];
+        const Slice& line = lineSlices[curve];
+        if(!dirty[curve] && line.count==0 && lineCount(curve)==0 && pointSlices[curve].count==c.Points().size()) {
+            c.SetPoint(index,pos);
+            boundsDirty[curve] = 1;
+            controlPoints[pointSlices[curve].first+index] = pos;
+            Update update;
+            update.points = {pointSlices[curve].first+index,1};
+            return update;
+        }
+        if(dirty[curve] || c.GetTessellationMode()!=BezierCurve::TessellationMode::Uniform || line.count!=c.SampleCount()
+            || pointSlices[curve].count!=c.Points().size()) {
+            c.SetPoint(index,pos);
+            MarkDirty(curve);
+            return {};
+        }
+        Update update;
+        const BezierCurve::DirtyRange range = c.MovePoint(index,pos,vertices.data()+line.first);
+        lineRevisions[curve]++;
+        boundsDirty[curve] = 1;
+        calcChunkBoxes(curve,range.first,range.count);
+        calcLods(curve,range.first,range.count);
+        update.lines = {line.first+range.first,LodTotal(line.count)-range.first};
+        controlPoints[pointSlices[curve].first+index] = pos;
+        update.points = {pointSlices[curve].first+index,1};
+        return update;
+    }
+    //adaptive curves are done first since their vertex count decides the layout, then every dirty curve in view goes into its slice
+    //the others stay dirty with a stale line, only their control points are copied
+    void BeginTessellation(ThreadPool& pool) {
+        tessellationStart = std::chrono::steady_clock::now();
+        pending = {};
+        refreshBounds();
+        bool adaptive = false;
+        for(size_t i=0;i<curves.size();i++) {
+            if(dirty[i] && inView(i) && curves[i].GetTessellationMode()!=BezierCurve::TessellationMode::Uniform && curves[i].Points().size()>=minLinePoints) {
+                pool.Submit([this,i] { curves[i].RecalculateLine(); });
+                adaptive = true;
+            }
+        }
+        if(adaptive) {
+            pool.Wait();
+        }
+        pending.resized = calcLayout();
+        for(size_t i=0;i<curves.size();i++) {
+            if(!dirty[i]) {
+                continue;
+            }
+            if(!inView(i)) {
+                copyPoints(i);
+                merge(pending.points,pointSlices[i].first,pointSlices[i].count);
+                continue;
+            }
+            dirty[i] = 0;
+            merge(pending.lines,lineSlices[i].first,LodTotal(lineSlices[i].count));
+            merge(pending.points,pointSlices[i].first,pointSlices[i].count);
+            pool.Submit([this,i] { tessellate(i); });
+        }
+    }
+    //completion barrier, after it the arenas can be uploaded
+    Update FinishTessellation(ThreadPool& pool) {
+        pool.Wait();
+        tessellationMicroseconds = std::chrono::duration<double,std::micro>(std::chrono::steady_clock::now()-tessellationStart).count();
+        return pending;
+    }
+    //visible curves and the vertex ranges of their visible chunks at their level of detail, call it after FinishTessellation
+    void Cull() {
+        refreshBounds();
+        visibleCurves.clear();
+        visibleLines.clear();
+        curveTree.Query(view,curveBoxes.data(),[this](const uint32_t curve) {
+            visibleCurves.push_back(curve);
+        });
+        std::sort(visibleCurves.begin(),visibleCurves.end());
+        for(const uint32_t curve : visibleCurves) {
+            const Slice& line = lineSlices[curve];
+            lods[curve] = static_cast<uint8_t>(chooseLod(curve,line.count>0 ? line.count : curves[curve].SampleCount()));
+            if(dirty[curve] || line.count==0) {
+                continue;
+            }
+            const size_t level = lods[curve];
+            const Slice lod = LodSlice(curve,level);
+            const Slice& chunks = chunkSlices[curve];
+            const size_t firstRun = visibleLines.size();
+            for(size_t k=0;k<chunks.count;k++) {
+                if(!chunkBoxes[chunks.first+k].Intersects(view)) {
+                    continue;
+                }
+                //the chunk's vertices and the ones of the level around them
+                const size_t first = lod.first+((k*chunkVertices)>>level);
+                const size_t last = lod.first+std::min((std::min((k+1)*chunkVertices,line.count-1)+(size_t(1)<<level)-1)>>level,lod.count-1);
+                if(visibleLines.size()>firstRun && first<visibleLines.back().first+visibleLines.back().count) {
+                    visibleLines.back().count = last+1-visibleLines.back().first;
+                }else {
+                    visibleLines.push_back({first,last+1-first});
+                }
+            }
+        }
+    }
+    const std::pmr::vector<uint32_t>& VisibleCurves() const {
+        return visibleCurves;
+    }
+    const std::pmr::vector<Slice>& VisibleLines() const {
+        return visibleLines;
+    }
+    const std::pmr::vector<glm::vec2>& Vertices() const {
+        return vertices;
+    }
+    const std::pmr::vector<glm::vec2>& ControlPoints() const {
+        return controlPoints;
+    }
+    //the finest level of the curve's line
+    const Slice& LineSlice(const size_t curve) const {
+        return lineSlices[curve];
+    }
+    Slice LodSlice(const size_t curve, const size_t level) const {
+        const Slice& line = lineSlices[curve];
+        Slice lod{line.first,LodCount(line.count,0)};
+        for(size_t i=0;i<level;i++) {
+            lod.first += lod.count;
+            lod.count = LodCount(line.count,i+1);
+        }
+        return lod;
+    }
+    //level picked for the curve by the last Cull
+    size_t Lod(const size_t curve) const {
+        return lods[curve];
+    }
+    const Slice& PointSlice(const size_t curve) const {
+        return pointSlices[curve];
+    }
+    //changes whenever the line vertices of the curve changed, for anything derived from them
+    uint32_t LineRevision(const size_t curve) const {
+        return lineRevisions[curve];
+    }
+    //wall time of the last BeginTessellation..FinishTessellation
+    double TessellationMicroseconds() const {
+        return tessellationMicroseconds;
+    }
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <cstddef>
+#include <istream>
+#include <string>
+#include <vector>
+
+//edits to play back one frame at a time, for rendering without anyone at the mouse
+//text format, one command per line, anything after # is a comment:
+//  drag <curve> <point> <dx> <dy> <frames>   moves a control point by dx dy in equal steps over frames
+//  insert <curve> <x> <y>                    appends a control point
+//  curve                                     adds an empty curve, "last" as a curve index refers to the newest one
+//  precision <factor>                        scales the precision of every curve
+//  wait <frames>                             frames without edits
+//curve and point indices wrap around the counts of the scene it is played on, so any script fits any scene
+class EditScript {
+public:
+	enum class Kind : uint8_t {
+		Wait,
+		Drag,
+		Insert,
+		NewCurve,
+		Precision
+	};
+	//what one frame does, value is the offset of a drag or the point of an insert
+	struct Step {
+		Kind kind = Kind::Wait;
+		uint32_t curve = 0;
+		uint32_t point = 0;
+		glm::vec2 value{0.0f};
+		float factor = 1.0f;
+	};
+	static constexpr uint32_t lastCurve = UINT32_MAX;
+
+	//false with Error() set at the first line that doesn't parse, the script is empty then
+	bool Load(std::istream& in);
+	bool Load(const std::string& path);
+	//every curve in turn has a point dragged around a circle, with an insert every insertEvery frames
+	//and a precision change every precisionEvery frames that the next one takes back, 0 leaves them out
+	static EditScript Synthetic(size_t frames, size_t insertEvery = 30, size_t precisionEvery = 120);
+
+	size_t FrameCount() const {
+		return frames.size();
+	}
+	const Step& Frame(const size_t frame) const {
+		return frames[frame];
+	}
+	const std::string& Error() const {
+		return error;
+	}
+private:
+	std::vector<Step> frames;
+	std::string error;
+};
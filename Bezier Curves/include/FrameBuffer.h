@@ -0,0 +1,26 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <vector>
+
+//offscreen color target with one RGBA8 renderbuffer, for rendering without a visible window
+class FrameBuffer {
+public:
+	GLuint id = 0;
+	//false when the driver reports it incomplete, nothing is left bound then
+	bool create(GLsizei width, GLsizei height);
+	void destroy();
+	//draws and reads go to it until unbind
+	void bind() const;
+	static void unbind();
+	//4 bytes per pixel, rows bottom up as GL returns them
+	void readPixels(std::vector<uint8_t>& rgba) const;
+	GLsizei getWidth() const;
+	GLsizei getHeight() const;
+private:
+	GLuint colorBuffer = 0;
+	GLsizei width = 0;
+	GLsizei height = 0;
+};
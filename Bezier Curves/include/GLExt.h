@@ -0,0 +1,36 @@
+#pragma once
+
+#include <glad/glad.h>
+
+//the context is created as 3.3 core, entry points and enums from later versions are looked up here when the driver has them
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+
+class GLExt {
+public:
+	GLExt() = delete;
+	//call once after gladLoadGLLoader with the same loader
+	static void load(GLADloadproc loader);
+	//glBufferStorage, core in 4.4 or through GL_ARB_buffer_storage
+	static bool hasBufferStorage();
+	static void bufferStorage(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+	//glGetProgramBinary and glProgramBinary, core in 4.1 or through GL_ARB_get_program_binary, and at least one binary format
+	static bool hasProgramBinary();
+	static void programParameteri(GLuint program, GLenum name, GLint value);
+	static void getProgramBinary(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+	static void programBinary(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+	static bool hasExtension(const char* name);
+};
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include "Profiler.h"
+
+#include <cstdint>
+#include <cstddef>
+
+//gpu durations of profiler sections from GL_TIMESTAMP queries around them
+//results are read latency frames later and only when they are ready, so the cpu never waits for them
+class GpuTimer {
+public:
+	static const int latency = 3;
+	//timestamps per frame, sections past it are not timed
+	static const int maxQueries = 64;
+
+	void create();
+	void destroy();
+	//false when the driver has no timestamp bits, begin and end do nothing then
+	bool isAvailable() const;
+	//hands the finished results of an old frame to Profiler::AddGpuTime and starts recording for frame
+	void beginFrame(uint64_t frame);
+	//begin and end pairs nest like scopes
+	void begin(size_t section);
+	void end();
+
+	class Scope {
+	public:
+		Scope(GpuTimer& timer, size_t section);
+		~Scope();
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+	private:
+		GpuTimer& timer;
+	};
+private:
+	struct Range {
+		size_t section;
+		int first;
+		int last;
+	};
+	GLuint queries[latency][maxQueries] = {};
+	Range ranges[latency][maxQueries/2] = {};
+	int queryCount[latency] = {};
+	int rangeCount[latency] = {};
+	uint64_t frames[latency] = {};
+	int open[maxQueries/2] = {};
+	int openCount = 0;
+	int current = 0;
+	bool available = false;
+};
+
+#if BEZIER_PROFILE
+//gpu time of the enclosing block under the profiler section name
+#define PROFILE_GPU_SCOPE(timer,name) static const size_t PROFILE_CONCAT(profileGpuSection,__LINE__) = Profiler::Section(name); \
+	const GpuTimer::Scope PROFILE_CONCAT(profileGpuScope,__LINE__)(timer,PROFILE_CONCAT(profileGpuSection,__LINE__))
+#else
+#define PROFILE_GPU_SCOPE(timer,name) do {} while(false)
+#endif
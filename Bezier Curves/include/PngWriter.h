@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+//8 bit RGBA png files without a compression library, the image data goes into stored deflate blocks
+//so files are as large as the pixels but byte for byte the same for the same pixels, which is what golden images need
+namespace PngWriter {
+	//rgba has width*height*4 bytes, bottomUp for rows in the order glReadPixels returns them
+	bool Write(const std::string& path, const uint8_t* rgba, uint32_t width, uint32_t height, bool bottomUp = false);
+}
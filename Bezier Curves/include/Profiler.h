@@ -0,0 +1,253 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+
+//frame stats for the main thread: scoped cpu timers, gpu times reported later by a GpuTimer and named counters
+//with BEZIER_PROFILE 0 the macros below expand to nothing, so instrumented code costs nothing
+//the project defines BEZIER_PROFILE=1 in its Debug configurations only, Release builds leave it out
+#ifndef BEZIER_PROFILE
+#define BEZIER_PROFILE 0
+#endif
+
+class Profiler {
+public:
+    static constexpr size_t maxSections = 32;
+    static constexpr size_t maxCounters = 16;
+    //frames kept in the ring, older ones are overwritten
+    static constexpr size_t historyFrames = 256;
+    //scopes kept for the trace export, a ring as well
+    static constexpr size_t maxEvents = 16384;
+    struct Frame {
+        uint64_t number = 0;
+        double start = 0.0;//microseconds since the profiler started
+        double duration = 0.0;
+        std::array<double,maxSections> cpu{};
+        //-1 until the gpu timer delivered it, stays so without timer queries
+        std::array<double,maxSections> gpu{};
+        std::array<uint32_t,maxSections> calls{};
+        std::array<int64_t,maxCounters> counters{};
+    };
+    struct Event {
+        uint64_t frame = 0;
+        uint32_t section = 0;
+        double start = 0.0;
+        double duration = 0.0;
+    };
+private:
+    using Clock = std::chrono::steady_clock;
+    inline static Clock::time_point epoch = Clock::now();
+    inline static std::array<const char*,maxSections> sectionNames{};
+    inline static size_t sectionCount = 0;
+    inline static std::array<const char*,maxCounters> counterNames{"allocations","allocated bytes"};
+    inline static size_t counterCount = 2;
+    //defined below the class, Frame and Event have to be complete first
+    static std::array<Frame,historyFrames> frames;
+    static std::array<Event,maxEvents> events;
+    inline static uint64_t frameNumber = 0;
+    inline static uint64_t eventNumber = 0;
+    //operator new runs on every thread
+    inline static std::atomic<uint64_t> allocations{0};
+    inline static std::atomic<uint64_t> allocatedBytes{0};
+    inline static uint64_t frameAllocations = 0;
+    inline static uint64_t frameAllocatedBytes = 0;
+    template<size_t max>
+    static size_t find(const char* name, std::array<const char*,max>& names, size_t& count) {
+        for(size_t i=0;i<count;i++) {
+            if(std::strcmp(names[i],name)==0) {
+                return i;
+            }
+        }
+        if(count==max) {//everything past the limit is booked on the last one
+            return max-1;
+        }
+        names[count] = name;
+        return count++;
+    }
+    static void writeEscaped(std::ostream& out, const char* text) {
+        for(;*text;text++) {
+            if(*text=='"' || *text=='\\') {
+                out << '\\';
+            }
+            out << *text;
+        }
+    }
+public:
+    Profiler() = delete;
+    static double Now() {
+        return std::chrono::duration<double,std::micro>(Clock::now()-epoch).count();
+    }
+    //names have to outlive the profiler, string literals in practice
+    static size_t Section(const char* name) {
+        return find(name,sectionNames,sectionCount);
+    }
+    static size_t Counter(const char* name) {
+        return find(name,counterNames,counterCount);
+    }
+    static const char* SectionName(const size_t section) {
+        return sectionNames[section];
+    }
+    static size_t SectionCount() {
+        return sectionCount;
+    }
+    static const char* CounterName(const size_t counter) {
+        return counterNames[counter];
+    }
+    static size_t CounterCount() {
+        return counterCount;
+    }
+    //closes the current frame and starts the next one
+    static void BeginFrame() {
+        const double now = Now();
+        const uint64_t total = allocations.load(std::memory_order_relaxed);
+        const uint64_t totalBytes = allocatedBytes.load(std::memory_order_relaxed);
+        if(frameNumber>0) {
+            Frame& last = frames[(frameNumber-1)%historyFrames];
+            last.duration = now-last.start;
+            last.counters[0] = static_cast<int64_t>(total-frameAllocations);
+            last.counters[1] = static_cast<int64_t>(totalBytes-frameAllocatedBytes);
+        }
+        frameAllocations = total;
+        frameAllocatedBytes = totalBytes;
+        Frame& frame = frames[frameNumber%historyFrames];
+        frame = Frame();
+        frame.number = frameNumber++;
+        frame.start = now;
+        frame.gpu.fill(-1.0);
+    }
+    //number of the frame BeginFrame started last
+    static uint64_t FrameNumber() {
+        return frameNumber>0 ? frameNumber-1 : 0;
+    }
+    static void AddTime(const size_t section, const double start, const double duration) {
+        if(frameNumber==0) {
+            return;
+        }
+        Frame& frame = frames[(frameNumber-1)%historyFrames];
+        frame.cpu[section] += duration;
+        frame.calls[section]++;
+        events[eventNumber%maxEvents] = {frame.number,static_cast<uint32_t>(section),start,duration};
+        eventNumber++;
+    }
+    //gpu times arrive a few frames late, frames that already left the ring are skipped
+    static void AddGpuTime(const uint64_t frameNumberOfTime, const size_t section, const double duration) {
+        Frame& frame = frames[frameNumberOfTime%historyFrames];
+        if(frame.number!=frameNumberOfTime) {
+            return;
+        }
+        frame.gpu[section] = frame.gpu[section]<0.0 ? duration : frame.gpu[section]+duration;
+    }
+    static void Count(const size_t counter, const int64_t value) {
+        if(frameNumber>0) {
+            frames[(frameNumber-1)%historyFrames].counters[counter] += value;
+        }
+    }
+    static void CountAllocation(const size_t bytes) {
+        allocations.fetch_add(1,std::memory_order_relaxed);
+        allocatedBytes.fetch_add(bytes,std::memory_order_relaxed);
+    }
+    //completed frames, 0 is the newest, at most historyFrames-1 of them
+    static size_t CompletedFrames() {
+        return frameNumber>0 ? std::min<uint64_t>(frameNumber-1,historyFrames-1) : 0;
+    }
+    static const Frame& CompletedFrame(const size_t age) {
+        return frames[(frameNumber-2-age)%historyFrames];
+    }
+    //times the enclosing block, main thread only
+    class Scope {
+        size_t section;
+        double start;
+    public:
+        explicit Scope(const size_t section):section(section),start(Now()) {}
+        ~Scope() {
+            AddTime(section,start,Now()-start);
+        }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+    //a row per completed frame, the times in microseconds
+    static void WriteCsv(std::ostream& out) {
+        out << "frame,start_us,frame_us";
+        for(size_t s=0;s<sectionCount;s++) {
+            out << "," << sectionNames[s] << " cpu_us," << sectionNames[s] << " gpu_us," << sectionNames[s] << " calls";
+        }
+        for(size_t c=0;c<counterCount;c++) {
+            out << "," << counterNames[c];
+        }
+        out << "\n";
+        for(size_t age=CompletedFrames();age-->0;) {
+            const Frame& frame = CompletedFrame(age);
+            out << frame.number << "," << frame.start << "," << frame.duration;
+            for(size_t s=0;s<sectionCount;s++) {
+                out << "," << frame.cpu[s] << ",";
+                if(frame.gpu[s]>=0.0) {
+                    out << frame.gpu[s];
+                }
+                out << "," << frame.calls[s];
+            }
+            for(size_t c=0;c<counterCount;c++) {
+                out << "," << frame.counters[c];
+            }
+            out << "\n";
+        }
+    }
+    //chrome://tracing and Perfetto format, scopes as complete events, gpu times and counters as counter tracks
+    static void WriteChromeTrace(std::ostream& out) {
+        out << "{\"traceEvents\":[\n";
+        bool first = true;
+        const auto separator = [&] {
+            out << (first ? "" : ",\n");
+            first = false;
+        };
+        const uint64_t eventTotal = std::min<uint64_t>(eventNumber,maxEvents);
+        for(uint64_t i=eventNumber-eventTotal;i<eventNumber;i++) {
+            const Event& event = events[i%maxEvents];
+            separator();
+            out << "{\"name\":\"";
+            writeEscaped(out,sectionNames[event.section]);
+            out << "\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":" << event.start << ",\"dur\":" << event.duration
+                << ",\"args\":{\"frame\":" << event.frame << "}}";
+        }
+        for(size_t age=CompletedFrames();age-->0;) {
+            const Frame& frame = CompletedFrame(age);
+            for(size_t s=0;s<sectionCount;s++) {
+                if(frame.gpu[s]<0.0) {
+                    continue;
+                }
+                separator();
+                out << "{\"name\":\"gpu ";
+                writeEscaped(out,sectionNames[s]);
+                out << "\",\"ph\":\"C\",\"pid\":1,\"ts\":" << frame.start << ",\"args\":{\"us\":" << frame.gpu[s] << "}}";
+            }
+            for(size_t c=0;c<counterCount;c++) {
+                separator();
+                out << "{\"name\":\"";
+                writeEscaped(out,counterNames[c]);
+                out << "\",\"ph\":\"C\",\"pid\":1,\"ts\":" << frame.start << ",\"args\":{\"value\":" << frame.counters[c] << "}}";
+            }
+        }
+        out << "\n]}\n";
+    }
+};
+
+inline std::array<Profiler::Frame,Profiler::historyFrames> Profiler::frames{};
+inline std::array<Profiler::Event,Profiler::maxEvents> Profiler::events{};
+
+#define PROFILE_CONCAT_INNER(a,b) a##b
+#define PROFILE_CONCAT(a,b) PROFILE_CONCAT_INNER(a,b)
+#if BEZIER_PROFILE
+//the section is looked up once per call site
+#define PROFILE_SCOPE(name) static const size_t PROFILE_CONCAT(profileSection,__LINE__) = Profiler::Section(name); \
+    const Profiler::Scope PROFILE_CONCAT(profileScope,__LINE__)(PROFILE_CONCAT(profileSection,__LINE__))
+#define PROFILE_COUNT(name,value) do { static const size_t profileCounter = Profiler::Counter(name); Profiler::Count(profileCounter,(value)); } while(false)
+#define PROFILE_FRAME() Profiler::BeginFrame()
+#else
+#define PROFILE_SCOPE(name) do {} while(false)
+#define PROFILE_COUNT(name,value) do {} while(false)
+#define PROFILE_FRAME() do {} while(false)
+#endif
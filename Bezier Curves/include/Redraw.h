@@ -0,0 +1,41 @@
+#pragma once
+
+#include <GLFW/glfw3.h>
+#include <atomic>
+
+//frames are only drawn after something asked for one, the loop sleeps in glfwWaitEventsTimeout otherwise
+class Redraw {
+private:
+    inline static std::atomic<bool> requested{true};
+public:
+    Redraw() = delete;
+    //longest sleep without events
+    inline static double idleTimeout = 0.5;
+    inline static unsigned long long framesDrawn = 0;
+    inline static unsigned long long framesSkipped = 0;
+    static void Request() {
+        requested.store(true,std::memory_order_relaxed);
+    }
+    //from threads other than the main one, also wakes up a waiting loop
+    static void RequestFromThread() {
+        Request();
+        glfwPostEmptyEvent();
+    }
+    //processes the events, waiting for them when no frame is due
+    static void WaitEvents() {
+        if(requested.load(std::memory_order_relaxed)) {
+            glfwPollEvents();
+        }else {
+            glfwWaitEventsTimeout(idleTimeout);
+        }
+    }
+    //true when a frame has to be drawn, it covers every request made up to here
+    static bool BeginFrame() {
+        if(!requested.exchange(false,std::memory_order_relaxed)) {
+            framesSkipped++;
+            return false;
+        }
+        framesDrawn++;
+        return true;
+    }
+};
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <vector>
+
+//binary scene: a header, the control points of every curve back to back as float pairs, then an index of the curves
+//  Header      64 bytes at offset 0
+//  points      pointCount glm::vec2, starting at pointsOffset which is a multiple of alignment
+//  CurveEntry  curveCount entries of 16 bytes at indexOffset, also a multiple of alignment
+//everything is stored in the byte order of the writer, so a mapped file is used in place without parsing
+//the index comes last so the points can be streamed out before the number of curves is known
+namespace SceneFormat {
+	constexpr char magic[8] = {'B','Z','S','C','E','N','E','\0'};
+	constexpr uint32_t version = 1;
+	//written as is, reads back differently on a machine of the other byte order
+	constexpr uint32_t byteOrderMark = 0x01020304;
+	constexpr size_t alignment = 64;
+	//a curve's evaluation is O(n) per sample anyway, more points than its 32 bit count holds are no use
+	constexpr uint64_t maxCurvePoints = UINT32_MAX;
+	struct Header {
+		char magic[8];
+		uint32_t version;
+		uint32_t byteOrder;
+		uint64_t curveCount;
+		uint64_t pointCount;
+		uint64_t pointsOffset;
+		uint64_t indexOffset;
+		uint64_t fileSize;
+		uint32_t headerSize;
+		uint32_t reserved;
+	};
+	struct CurveEntry {
+		uint64_t firstPoint;
+		uint32_t pointCount;
+		float precision;
+	};
+	static_assert(sizeof(Header)==64 && sizeof(CurveEntry)==16,"the layout is part of the format");
+	static_assert(sizeof(glm::vec2)==2*sizeof(float),"points are used in place as glm::vec2");
+}
+
+//read only mapping of a scene file, the points and the index are pointers into it
+class SceneFile {
+public:
+	struct Curve {
+		const glm::vec2* points = nullptr;
+		size_t count = 0;
+		float precision = 0.01f;
+	};
+private:
+	const unsigned char* data = nullptr;
+	size_t size = 0;
+#ifdef _WIN32
+	void* fileHandle = nullptr;
+	void* mappingHandle = nullptr;
+#endif
+	const SceneFormat::Header* header = nullptr;
+	const glm::vec2* points = nullptr;
+	const SceneFormat::CurveEntry* entries = nullptr;
+	std::string error;
+	bool fail(const std::string& message);
+	bool validate();
+public:
+	SceneFile() = default;
+	explicit SceneFile(const std::string& path) {
+		Open(path);
+	}
+	~SceneFile() {
+		Close();
+	}
+	SceneFile(const SceneFile&) = delete;
+	SceneFile& operator=(const SceneFile&) = delete;
+	//maps the file and checks the header and the index, false with Error() set when it isn't a usable scene
+	bool Open(const std::string& path);
+	void Close();
+	bool IsOpen() const {
+		return header!=nullptr;
+	}
+	const std::string& Error() const {
+		return error;
+	}
+	size_t CurveCount() const {
+		return header ? static_cast<size_t>(header->curveCount) : 0;
+	}
+	size_t PointCount() const {
+		return header ? static_cast<size_t>(header->pointCount) : 0;
+	}
+	//all control points of all curves
+	const glm::vec2* Points() const {
+		return points;
+	}
+	Curve CurveAt(const size_t curve) const {
+		const SceneFormat::CurveEntry& entry = entries[curve];
+		return {points+entry.firstPoint,entry.pointCount,entry.precision};
+	}
+};
+
+//writes a scene curve by curve without holding its points, only the 16 byte index entries are kept until Finish
+class SceneWriter {
+	std::ofstream file;
+	std::vector<SceneFormat::CurveEntry> entries;
+	uint64_t pointCount = 0;
+	bool curveOpen = false;
+	bool finished = false;
+	//a write or a curve failed, the scene is incomplete and Finish doesn't make it a valid file
+	bool failed = false;
+public:
+	SceneWriter() = default;
+	explicit SceneWriter(const std::string& path) {
+		Open(path);
+	}
+	~SceneWriter() {
+		Finish();
+	}
+	SceneWriter(const SceneWriter&) = delete;
+	SceneWriter& operator=(const SceneWriter&) = delete;
+	bool Open(const std::string& path);
+	void BeginCurve(float precision = 0.01f);
+	//a curve can't hold more than SceneFormat::maxCurvePoints, points past that are rejected and fail the scene
+	void AddPoints(const glm::vec2* points, size_t count);
+	void AddPoint(const glm::vec2 point) {
+		AddPoints(&point,1);
+	}
+	void EndCurve();
+	//a whole curve at once
+	void AddCurve(const glm::vec2* points, const size_t count, const float precision = 0.01f) {
+		BeginCurve(precision);
+		AddPoints(points,count);
+		EndCurve();
+	}
+	size_t CurveCount() const {
+		return entries.size();
+	}
+	//writes the index and the header, false when anything failed to write or a curve got too many points
+	bool Finish();
+};
+
+//converters from text formats into a SceneWriter, they return the number of curves written
+namespace SceneImport {
+	//every segment of the path elements' d attributes becomes a curve of its control points
+	//absolute and relative M L H V C S Q T Z are read, arcs become lines and transforms are ignored
+	size_t Svg(std::istream& in, SceneWriter& writer, float precision = 0.01f);
+	//one "x y" pair per line, a line starting with "curve" begins the next curve and may carry its precision
+	//blank lines and lines starting with # are skipped
+	size_t Text(std::istream& in, SceneWriter& writer, float precision = 0.01f);
+}
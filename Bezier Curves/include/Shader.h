@@ -7,6 +7,7 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <unordered_map>
 
 class Shader
 {
@@ -14,13 +15,19 @@ public:
 	// the program id
 	GLuint id;
 
-	// constructor reads and builds the shader
+	// where linked programs are kept between launches, empty turns the cache off
+	static std::string binaryCacheDirectory;
+
+	// constructor reads and builds the shader, or loads the binary cached for the same sources and driver
 	Shader(const char* vertexPath, const char* fragmentPath);
 	Shader(const char* vertexPath, const char* geometryPath, const char* fragmentPath);
 
 	// use/activate the shader
 	void use() const;
 
+	// uniform locations are resolved once after linking, -1 for names the program doesn't use
+	GLint getUniformLocation(const std::string& name) const;
+
 	// utility uniform functions
 	GLuint getUniformIndex(const std::string& name) const;
 
@@ -42,4 +49,23 @@ public:
 	void setMat2(const std::string& name, const glm::mat2& mat) const;
 	void setMat3(const std::string& name, const glm::mat3& mat) const;
 	void setMat4(const std::string& name, const glm::mat4& mat) const;
+
+	// the same setters for a location from getUniformLocation, without any lookup
+	void setBool(GLint location, bool value) const;
+	void setInt(GLint location, int value) const;
+	void setFloat(GLint location, float value) const;
+	void setVec2(GLint location, const glm::vec2& value) const;
+	void setVec2(GLint location, float x, float y) const;
+	void setVec3(GLint location, const glm::vec3& value) const;
+	void setVec4(GLint location, const glm::vec4& value) const;
+	void setMat2(GLint location, const glm::mat2& mat) const;
+	void setMat3(GLint location, const glm::mat3& mat) const;
+	void setMat4(GLint location, const glm::mat4& mat) const;
+private:
+	void build(const GLenum* types, const std::string* sources, int count);
+	bool loadBinary(const std::string& path);
+	void saveBinary(const std::string& path) const;
+	void cacheUniforms();
+
+	std::unordered_map<std::string, GLint> uniformLocations;
 };
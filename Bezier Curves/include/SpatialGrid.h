@@ -0,0 +1,193 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+//uniform grid for picking, cells are hashed by their integer coordinates so the scene needs no bounds
+//an item is listed in every cell its box touches, a query only visits the cells around its radius
+template<class Item>
+class SpatialGrid {
+    static uint64_t key(const int x, const int y) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(x))<<32) | static_cast<uint32_t>(y);
+    }
+    glm::ivec2 cellOf(const glm::vec2 pos) const {
+        return {static_cast<int>(std::floor(pos.x/cellSize)),static_cast<int>(std::floor(pos.y/cellSize))};
+    }
+    template<class F>
+    void forCells(const glm::vec2 min, const glm::vec2 max, F f) const {
+        const glm::ivec2 first = cellOf(min);
+        const glm::ivec2 last = cellOf(max);
+        for(int x=first.x;x<=last.x;x++) {
+            for(int y=first.y;y<=last.y;y++) {
+                f(key(x,y));
+            }
+        }
+    }
+    float cellSize;
+    //emptied lists stay in the map, dragging a point back and forth doesn't allocate
+    std::unordered_map<uint64_t,std::vector<Item>> cells;
+public:
+    //picking radius is the natural cell size, a query then visits at most 3x3 cells
+    explicit SpatialGrid(const float cellSize):cellSize(cellSize) {}
+    void Insert(const Item& item, const glm::vec2 min, const glm::vec2 max) {
+        forCells(min,max,[&](const uint64_t cell) {
+            cells[cell].push_back(item);
+        });
+    }
+    //item has to compare equal to the inserted one and the box has to be the one it was inserted with
+    void Erase(const Item& item, const glm::vec2 min, const glm::vec2 max) {
+        forCells(min,max,[&](const uint64_t cell) {
+            const auto it = cells.find(cell);
+            if(it==cells.end()) {
+                return;
+            }
+            std::vector<Item>& list = it->second;
+            const auto found = std::find(list.begin(),list.end(),item);
+            if(found!=list.end()) {
+                *found = list.back();
+                list.pop_back();
+            }
+        });
+    }
+    //for point items, an item staying in its cell is just updated
+    void Move(const Item& item, const glm::vec2 from, const glm::vec2 to) {
+        if(cellOf(from)!=cellOf(to)) {
+            Erase(item,from,from);
+            Insert(item,to,to);
+            return;
+        }
+        const glm::ivec2 cell = cellOf(to);
+        const auto it = cells.find(key(cell.x,cell.y));
+        if(it!=cells.end()) {
+            const auto found = std::find(it->second.begin(),it->second.end(),item);
+            if(found!=it->second.end()) {
+                *found = item;
+            }
+        }
+    }
+    void Clear() {
+        for(auto& cell : cells) {
+            cell.second.clear();
+        }
+    }
+    //drops every item, for filling the grid again when the radius of the queries changed a lot
+    void Reset(const float size) {
+        cellSize = size;
+        cells.clear();
+    }
+    //distance(item) for the items near pos, false when none is within radius
+    template<class Distance>
+    bool Nearest(const glm::vec2 pos, const float radius, Distance distance, Item& nearest, float& nearestDistance) const {
+        bool found = false;
+        nearestDistance = radius;
+        forCells(pos-glm::vec2(radius),pos+glm::vec2(radius),[&](const uint64_t cell) {
+            const auto it = cells.find(cell);
+            if(it==cells.end()) {
+                return;
+            }
+            for(const Item& item : it->second) {
+                const float d = distance(item);
+                if(d<=nearestDistance) {
+                    nearest = item;
+                    nearestDistance = d;
+                    found = true;
+                }
+            }
+        });
+        return found;
+    }
+    float CellSize() const {
+        return cellSize;
+    }
+};
+
+//segments of tessellated lines, a curve's segments are replaced as a whole when its line changed
+class LineGrid {
+public:
+    struct Hit {
+        size_t curve = 0;
+        size_t segment = 0;
+        //closest point on the segment and how far along the segment it is
+        glm::vec2 pos{0.0f};
+        float fraction = 0.0f;
+        float distance = 0.0f;
+    };
+private:
+    struct Segment {
+        uint32_t curve;
+        uint32_t index;
+        glm::vec2 a;
+        glm::vec2 b;
+        bool operator==(const Segment& other) const {
+            return curve==other.curve && index==other.index;
+        }
+    };
+    static float closestFraction(const Segment& s, const glm::vec2 pos) {
+        const glm::vec2 d = s.b-s.a;
+        const float length2 = glm::dot(d,d);
+        return length2>0.0f ? std::clamp(glm::dot(pos-s.a,d)/length2,0.0f,1.0f) : 0.0f;
+    }
+    //a long diagonal segment would cover a big box of cells, it's listed under the boxes of cell sized pieces instead
+    template<class F>
+    void forPieces(const Segment& s, F f) const {
+        const int pieces = std::max(1,static_cast<int>(std::ceil(glm::length(s.b-s.a)/grid.CellSize())));
+        for(int i=0;i<pieces;i++) {
+            const glm::vec2 from = s.a+(s.b-s.a)*(static_cast<float>(i)/pieces);
+            const glm::vec2 to = s.a+(s.b-s.a)*(static_cast<float>(i+1)/pieces);
+            f(glm::min(from,to),glm::max(from,to));
+        }
+    }
+    SpatialGrid<Segment> grid;
+    std::vector<std::vector<Segment>> lines;
+public:
+    explicit LineGrid(const float cellSize):grid(cellSize) {}
+    //drops every line
+    void Reset(const float cellSize) {
+        grid.Reset(cellSize);
+        lines.clear();
+    }
+    float CellSize() const {
+        return grid.CellSize();
+    }
+    void SetLine(const size_t curve, const glm::vec2* vertices, const size_t count) {
+        if(curve>=lines.size()) {
+            lines.resize(curve+1);
+        }
+        std::vector<Segment>& line = lines[curve];
+        for(const Segment& s : line) {
+            forPieces(s,[&](const glm::vec2 min, const glm::vec2 max) {
+                grid.Erase(s,min,max);
+            });
+        }
+        line.clear();
+        for(size_t i=0;i+1<count;i++) {
+            const Segment s{static_cast<uint32_t>(curve),static_cast<uint32_t>(i),vertices[i],vertices[i+1]};
+            forPieces(s,[&](const glm::vec2 min, const glm::vec2 max) {
+                grid.Insert(s,min,max);
+            });
+            line.push_back(s);
+        }
+    }
+    bool Nearest(const glm::vec2 pos, const float radius, Hit& hit) const {
+        Segment nearest{};
+        float distance = 0.0f;
+        const auto segmentDistance = [pos](const Segment& s) {
+            const float f = closestFraction(s,pos);
+            return glm::length(s.a+(s.b-s.a)*f-pos);
+        };
+        if(!grid.Nearest(pos,radius,segmentDistance,nearest,distance)) {
+            return false;
+        }
+        hit.curve = nearest.curve;
+        hit.segment = nearest.index;
+        hit.fraction = closestFraction(nearest,pos);
+        hit.pos = nearest.a+(nearest.b-nearest.a)*hit.fraction;
+        hit.distance = distance;
+        return true;
+    }
+};
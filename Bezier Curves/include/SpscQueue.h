@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+//bounded ring for exactly one producer thread and one consumer thread, without locks and without allocations after construction
+//slots are filled and read in place, so whatever a slot owns keeps its capacity from one use to the next
+template<class T>
+class SpscQueue {
+public:
+    explicit SpscQueue(const size_t capacity):slots(capacity+1) {}
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+    //producer: the slot to fill, nullptr while the queue is full
+    T* BeginPush() {
+        const size_t current = tail.load(std::memory_order_relaxed);
+        const size_t following = next(current);
+        if(following==cachedHead) {
+            cachedHead = head.load(std::memory_order_acquire);
+            if(following==cachedHead) {
+                return nullptr;
+            }
+        }
+        return &slots[current];
+    }
+    //producer: hands the slot of the last BeginPush to the consumer
+    void EndPush() {
+        tail.store(next(tail.load(std::memory_order_relaxed)),std::memory_order_release);
+    }
+    //consumer: the oldest slot, nullptr while the queue is empty
+    T* Front() {
+        const size_t current = head.load(std::memory_order_relaxed);
+        if(current==cachedTail) {
+            cachedTail = tail.load(std::memory_order_acquire);
+            if(current==cachedTail) {
+                return nullptr;
+            }
+        }
+        return &slots[current];
+    }
+    //consumer: gives the slot of Front back to the producer
+    void Pop() {
+        head.store(next(head.load(std::memory_order_relaxed)),std::memory_order_release);
+    }
+    size_t Capacity() const {
+        return slots.size()-1;
+    }
+private:
+    size_t next(const size_t index) const {
+        return index+1==slots.size() ? 0 : index+1;
+    }
+    std::vector<T> slots;
+    //each side's index and its copy of the other one share a cache line, the two sides don't
+    alignas(64) std::atomic<size_t> head{0};
+    size_t cachedTail = 0;
+    alignas(64) std::atomic<size_t> tail{0};
+    size_t cachedHead = 0;
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include "GLExt.h"
+#include "VBO.h"
+
+//one buffer split into regionCount regions that are written in turn while the gpu may still draw from the previous ones
+//persistently mapped when glBufferStorage exists, otherwise every write maps its region unsynchronized
+//each region gets a fence after the draws that read it and is only written again once that fence signaled
+//content written with write is tracked per region, so a region only gets what changed since it was written last
+class StreamVBO {
+public:
+	static const int regionCount = 3;
+	GLuint id = 0;
+
+	void create(GLsizeiptr regionSize);
+	void destroy();
+	//marks bytes of the content as changed, every region copies them with its next write
+	void invalidate(GLintptr first, GLsizeiptr count);
+	void invalidateAll();
+	//waits for the next region and copies into it what changed since it was written last, data is the whole content
+	//a size other than the last write's changes everything, returns the bytes copied
+	//grows every region first when size doesn't fit, which makes a new buffer, so id has to be bound to the vao again
+	GLsizeiptr write(const void* data, GLsizeiptr size);
+	//byte offset of the region written last, the region draws read from
+	GLintptr offset() const;
+	//after the draws of a frame, protects the current region until the gpu is done with it
+	void fence();
+	bool isPersistent() const;
+private:
+	struct Range {
+		GLintptr first = 0;
+		GLsizeiptr count = 0;
+	};
+	void allocate(GLsizeiptr size);
+	void wait(int region);
+
+	GLsizeiptr size = 0;
+	int current = 0;
+	bool persistent = false;
+	char* mapped = nullptr;
+	GLsync fences[regionCount] = {};
+	//bytes of the content each region doesn't have yet, and the size of the content, -1 when no region has any of it
+	Range stale[regionCount];
+	GLsizeiptr contentSize = -1;
+};
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include "BezierCurve.h"
+#include "BoundingBox.h"
+#include "CurveScene.h"
+#include "SpscQueue.h"
+#include "ThreadPool.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory_resource>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//tessellates a mirror of the edited curves on a thread of its own, input handling never waits for RecalculateLine
+//edits go through a lock-free queue, the worker applies all queued ones before it tessellates
+//structural edits are snapshots of whole curves, so edits arriving faster than it keeps up only cost copying the superseded ones
+//moved points are applied like CurveScene::MovePoint, which updates the samples incrementally instead of tessellating the curve again
+//finished frames are published through a triple buffer, the renderer swaps in the newest one without a lock
+class TessellationThread {
+public:
+	//a visible curve without line vertices, drawn from its control points by the gpu
+	struct PointCurve {
+		int32_t firstPoint;
+		int32_t pointCount;
+		int32_t samples;
+	};
+	//vertices changed by one vertex revision, the whole arena when its layout changed
+	struct VertexChange {
+		uint64_t revision;
+		CurveScene::Slice range;
+	};
+	//vertex revisions whose changes are kept, copies older than that are replaced whole
+	static constexpr size_t changeHistory = 8;
+	//what the renderer needs from the worker's scene after tessellating and culling it
+	struct Frame {
+		std::vector<glm::vec2> vertices;
+		std::vector<glm::vec2> controlPoints;
+		std::vector<CurveScene::Slice> visibleLines;
+		std::vector<PointCurve> pointCurves;
+		//the finest line of every curve and its CurveScene::LineRevision
+		std::vector<CurveScene::Slice> lineSlices;
+		std::vector<uint32_t> lineRevisions;
+		//change whenever the arrays do, so a frame that only culled again needs no upload
+		uint64_t vertexRevision = 0;
+		uint64_t pointRevision = 0;
+		//the last changeHistory vertex revisions up to this one, oldest first
+		std::vector<VertexChange> vertexChanges;
+		//the vertices that changed after revision, false when that goes further back than vertexChanges
+		bool ChangesSince(uint64_t revision, CurveScene::Slice& range) const;
+		//every edit up to this one is in the frame
+		uint64_t edit = 0;
+		double tessellationMicroseconds = 0.0;
+	};
+	static constexpr size_t queueCapacity = 4096;
+
+	//the pool is only used by the thread while it runs, onFrame is called on the thread after every published frame
+	explicit TessellationThread(ThreadPool& pool, std::function<void()> onFrame = nullptr);
+	~TessellationThread();
+	TessellationThread(const TessellationThread&) = delete;
+	TessellationThread& operator=(const TessellationThread&) = delete;
+	//edits queued while stopped are applied once it runs again
+	void Start();
+	void Stop();
+	bool IsRunning() const;
+
+	//producer side, from one thread at a time, every call returns false without queueing anything when the queue is full
+	//the curve's points and settings as they are now, curves that weren't submitted before are added up to this index
+	bool SubmitCurve(size_t curve, const BezierCurve& source);
+	//a point of a curve submitted before, moving one that the worker's curve doesn't have is ignored
+	bool SubmitMovePoint(size_t curve, size_t index, glm::vec2 pos);
+	bool SubmitView(const BoundingBox& view, float pixelsPerUnit);
+	bool SubmitMinLinePoints(size_t points);
+	//waits until a frame with every edit submitted so far is published, returns at once while stopped
+	void Flush();
+
+	//renderer side, true when a newer frame was published since the last call and is now Current
+	bool Acquire();
+	//nullptr until the first Acquire that returned true
+	const Frame* Current() const;
+
+	uint64_t FramesPublished() const;
+	//curve snapshots that were replaced by a newer one of the same curve before they were tessellated
+	uint64_t SupersededEdits() const;
+private:
+	enum class EditKind : uint8_t {
+		Curve,
+		MovePoint,
+		View,
+		MinLinePoints
+	};
+	struct Edit {
+		EditKind kind = EditKind::Curve;
+		uint64_t sequence = 0;
+		uint32_t curve = 0;
+		uint32_t point = 0;
+		glm::vec2 pos{0.0f};
+		std::vector<glm::vec2> points;
+		float precision = 0.01f;
+		float flatnessTolerance = 0.25f;
+		BezierCurve::EvaluationMode evaluationMode = BezierCurve::EvaluationMode::Bernstein;
+		BezierCurve::TessellationMode tessellationMode = BezierCurve::TessellationMode::Uniform;
+		BezierCurve::ScalarBackend scalarBackend = BezierCurve::ScalarBackend::Float;
+		BoundingBox view;
+		float pixelsPerUnit = 1.0f;
+		size_t minLinePoints = 0;
+	};
+	//slot of the triple buffer that was published last, with freshBit while no Acquire took it
+	static constexpr unsigned freshBit = 4;
+	static constexpr unsigned indexMask = 3;
+
+	Edit* beginEdit(EditKind kind);
+	void endEdit();
+	//moves are applied right away, what they changed is added to moved
+	void apply(const Edit& edit, CurveScene::Update& moved);
+	void publish(uint64_t edit);
+	void workerLoop();
+
+	ThreadPool& pool;
+	std::function<void()> onFrame;
+	SpscQueue<Edit> queue{queueCapacity};
+	uint64_t submitted = 0;
+	//worker side, the curves are tessellated on pool threads so their memory has to be synchronized
+	std::pmr::synchronized_pool_resource memory;
+	CurveScene scene{&memory};
+	std::vector<uint64_t> lastDrain;
+	uint64_t drain = 0;
+	//revisions start at 1, a renderer starts out with 0
+	uint64_t vertexRevision = 1;
+	uint64_t pointRevision = 1;
+	std::vector<VertexChange> vertexChanges;
+	Frame frames[3];
+	unsigned back = 0;
+	std::atomic<unsigned> ready{1};
+	unsigned front = 2;
+	bool acquired = false;
+	std::atomic<uint64_t> published{0};
+	std::atomic<uint64_t> framesPublished{0};
+	std::atomic<uint64_t> superseded{0};
+	//the worker sleeps when the queue is empty, the producer only takes the mutex to wake it
+	std::thread thread;
+	std::mutex sleepMutex;
+	std::condition_variable wake;
+	std::atomic<bool> sleeping{false};
+	bool stop = false;
+};
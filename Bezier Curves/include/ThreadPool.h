@@ -0,0 +1,51 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+
+//fixed set of workers with one task queue each, a worker out of tasks steals the oldest task of another one
+class ThreadPool {
+public:
+	using Task = std::function<void()>;
+	//0 means one worker per hardware thread except the calling one
+	explicit ThreadPool(unsigned threadCount = 0);
+	~ThreadPool();
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	//queues are filled round robin, the stealing evens out uneven tasks
+	void Submit(Task task);
+	//completion barrier, returns once every submitted task has finished
+	void Wait();
+	unsigned ThreadCount() const;
+private:
+	//ring buffer instead of a deque, it only allocates when it has to grow
+	struct Worker {
+		std::vector<Task> tasks;
+		size_t head = 0;
+		size_t count = 0;
+		std::mutex mutex;
+		void pushBack(Task task);
+		Task popBack();
+		Task popFront();
+	};
+	bool popOwn(unsigned index, Task& task);
+	bool steal(unsigned index, Task& task);
+	void workerLoop(unsigned index);
+
+	std::vector<std::unique_ptr<Worker>> workers;
+	std::vector<std::thread> threads;
+	unsigned nextWorker = 0;
+	//tasks not yet taken by a worker, and tasks not yet finished
+	std::atomic<size_t> queued{0};
+	std::atomic<size_t> unfinished{0};
+	std::mutex sleepMutex;
+	std::condition_variable wake;
+	std::condition_variable done;
+	bool stop = false;
+};
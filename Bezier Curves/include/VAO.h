@@ -9,6 +9,8 @@ public:
 	VAO() = delete;
 	static void generate(GLuint& id);
 	static void addAttrib(GLuint id, GLuint layout, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void* offset);
+	//integer attribute, read as int/ivec in the shader without conversion
+	static void addIntAttrib(GLuint id, GLuint layout, GLint size, GLenum type, GLsizei stride, const void* offset);
 	static void setAttribDivisor(GLuint id, GLuint index, GLuint divisor);
 	static void bind(GLuint id);
 	static void unbind();
@@ -0,0 +1,31 @@
+#version 330 core
+//one instance per curve, vertex i of the strip is B(i/(samples-1)) of the curve at firstPoint in controlPoints
+//every instance of a draw call draws as many vertices as the longest one, at most twice its own since Draw buckets the curves by samples
+//the ones past its samples repeat the end point
+
+layout(location = 0) in ivec3 aCurve;//first point, point count, samples
+
+uniform samplerBuffer controlPoints;
+
+uniform vec2 res;
+
+uniform mat4 projection;
+uniform mat4 model;
+
+void main(){
+    int firstPoint = aCurve.x;
+    int n = aCurve.y-1;
+    float t = min(float(gl_VertexID)/float(aCurve.z-1), 1.0);
+    //the second half is evaluated from the other end, that keeps u/s <= 1 and s^n away from 0
+    bool mirrored = t>0.5;
+    float u = mirrored ? 1.0-t : t;
+    float s = 1.0-u;
+    float ratio = u/s;
+    float weight = pow(s, float(n));//C(n,0) * u^0 * s^n, at least 2^-126 for the at most 127 points Draw gives it
+    vec2 pos = vec2(0.0);
+    for(int i=0;i<=n;i++){
+        pos += weight*texelFetch(controlPoints, firstPoint+(mirrored ? n-i : i)).xy;
+        weight *= ratio*float(n-i)/float(i+1);
+    }
+    gl_Position = projection * model * vec4(pos,1.0,1.0);
+}
@@ -2,8 +2,13 @@
 
 uniform vec3 color;
 
+in vec2 corner;
+
 void main(){
-	vec2 circCoord = 2.0*gl_PointCoord-1.0;
+	vec2 circCoord = corner;
+	if(dot(circCoord, circCoord)>1.0){
+		discard;
+	}
 	float alpha = (1 - pow(dot(circCoord, circCoord),2));
 	gl_FragColor = vec4(vec3(1.0), alpha);
 }
\ No newline at end of file
@@ -1,13 +1,19 @@
 #version 330 core
+//one instance per control point, the 4 vertices of the strip are the corners of its marker
 
 layout(location = 0) in vec2 aPos;
 
 uniform vec2 res;
+uniform float size;
 
 uniform mat4 projection;
 uniform mat4 model;
 
+out vec2 corner;
+
 void main(){
+    corner = vec2(gl_VertexID&1, gl_VertexID>>1)*2.0-1.0;
     gl_Position = projection * model * vec4(aPos,1.0,1.0);
+    gl_Position.xy += corner*size/res*gl_Position.w;
    // gl_Position = vec4(aPos/res*2-1, 1.0, 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,16 @@
+#version 330 core
+//coverage of a pixel by the capsule around the segment, from its distance to the segment in pixels
+
+uniform float width;
+
+in vec2 local;
+flat in float segmentLength;
+
+void main(){
+	float dist = length(vec2(local.x-clamp(local.x, 0.0, segmentLength), local.y));
+	float alpha = clamp(width*0.5+0.5-dist, 0.0, 1.0);
+	if(alpha<=0.0){
+		discard;
+	}
+	gl_FragColor = vec4(vec3(1.0), alpha);
+}
@@ -0,0 +1,61 @@
+#version 330 core
+//stroke_vs for the gpu tessellated curves, one instance per curve from lineShader_gpu_vs' attributes
+//the segment's end points are B(i/(samples-1)) and B((i+1)/(samples-1)) of the curve
+
+layout(location = 0) in ivec3 aCurve;//first point, point count, samples
+
+uniform samplerBuffer controlPoints;
+
+uniform vec2 res;
+uniform float width;
+
+uniform mat4 projection;
+uniform mat4 model;
+
+out vec2 local;
+flat out float segmentLength;
+
+const vec2 corners[6] = vec2[6](vec2(0.0,-1.0), vec2(1.0,-1.0), vec2(0.0,1.0), vec2(0.0,1.0), vec2(1.0,-1.0), vec2(1.0,1.0));
+
+vec2 toPixels(vec2 pos){
+    vec4 clip = projection * model * vec4(pos,1.0,1.0);
+    return (clip.xy/clip.w*0.5+0.5)*res;
+}
+
+//same evaluation as lineShader_gpu_vs
+vec2 evaluate(int index){
+    int firstPoint = aCurve.x;
+    int n = aCurve.y-1;
+    float t = min(float(index)/float(aCurve.z-1), 1.0);
+    bool mirrored = t>0.5;
+    float u = mirrored ? 1.0-t : t;
+    float s = 1.0-u;
+    float ratio = u/s;
+    float weight = pow(s, float(n));//normal for n<=126, see lineShader_gpu_vs
+    vec2 pos = vec2(0.0);
+    for(int i=0;i<=n;i++){
+        pos += weight*texelFetch(controlPoints, firstPoint+(mirrored ? n-i : i)).xy;
+        weight *= ratio*float(n-i)/float(i+1);
+    }
+    return pos;
+}
+
+void main(){
+    int segment = gl_VertexID/6;
+    if(segment>=aCurve.z-1){
+        local = vec2(0.0);
+        segmentLength = 0.0;
+        gl_Position = vec4(0.0, 0.0, 0.0, 1.0);
+        return;
+    }
+    vec2 p0 = toPixels(evaluate(segment));
+    vec2 p1 = toPixels(evaluate(segment+1));
+    float len = length(p1-p0);
+    vec2 dir = len>0.0 ? (p1-p0)/len : vec2(1.0, 0.0);
+    float extent = width*0.5+1.0;
+    vec2 corner = corners[gl_VertexID%6];
+    local = vec2(corner.x*(len+2.0*extent)-extent, corner.y*extent);
+    segmentLength = len;
+    vec2 pixel = p0 + dir*local.x + vec2(-dir.y, dir.x)*local.y;
+    gl_Position = vec4(pixel/res*2.0-1.0, 0.0, 1.0);
+}
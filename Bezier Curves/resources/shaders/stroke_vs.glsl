@@ -0,0 +1,47 @@
+#version 330 core
+//one instance per line, every 6 vertices are the two triangles of a quad around one of its segments
+//the quad covers the segment's capsule of width/2 plus a pixel, stroke_fs cuts the capsule out of it
+//capsules of neighbouring segments overlap in round joins, the ends get round caps
+//every instance of a draw call draws as many vertices as the longest one, at most twice its own since Draw buckets the lines by length
+//the quads past its last segment collapse to a point
+
+layout(location = 0) in ivec2 aLine;//first vertex in linePoints, vertex count
+
+uniform samplerBuffer linePoints;
+
+uniform vec2 res;
+uniform float width;
+
+uniform mat4 projection;
+uniform mat4 model;
+
+out vec2 local;
+flat out float segmentLength;
+
+const vec2 corners[6] = vec2[6](vec2(0.0,-1.0), vec2(1.0,-1.0), vec2(0.0,1.0), vec2(0.0,1.0), vec2(1.0,-1.0), vec2(1.0,1.0));
+
+vec2 toPixels(vec2 pos){
+    vec4 clip = projection * model * vec4(pos,1.0,1.0);
+    return (clip.xy/clip.w*0.5+0.5)*res;
+}
+
+void main(){
+    int segment = gl_VertexID/6;
+    if(segment>=aLine.y-1){
+        local = vec2(0.0);
+        segmentLength = 0.0;
+        gl_Position = vec4(0.0, 0.0, 0.0, 1.0);
+        return;
+    }
+    vec2 p0 = toPixels(texelFetch(linePoints, aLine.x+segment).xy);
+    vec2 p1 = toPixels(texelFetch(linePoints, aLine.x+segment+1).xy);
+    float len = length(p1-p0);
+    vec2 dir = len>0.0 ? (p1-p0)/len : vec2(1.0, 0.0);
+    float extent = width*0.5+1.0;
+    vec2 corner = corners[gl_VertexID%6];
+    //pixels along the segment from p0 and across it from the center line
+    local = vec2(corner.x*(len+2.0*extent)-extent, corner.y*extent);
+    segmentLength = len;
+    vec2 pixel = p0 + dir*local.x + vec2(-dir.y, dir.x)*local.y;
+    gl_Position = vec4(pixel/res*2.0-1.0, 0.0, 1.0);
+}
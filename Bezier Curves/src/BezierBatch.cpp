@@ -0,0 +1,391 @@
+#include "../include/BezierBatch.h"
+
+#include <array>
+#include <cstring>
+#include <utility>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define BEZIER_BATCH_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+//msvc emits any intrinsic without flags, gcc/clang need the target per function
+#if defined(__GNUC__) || defined(__clang__)
+#define BEZIER_TARGET(isa) __attribute__((target(isa)))
+#else
+#define BEZIER_TARGET(isa)
+#endif
+
+namespace {
+	using Kernel = void(*)(const float*, const float*, size_t, const float*, size_t, glm::vec2*);
+	using StepKernel = void(*)(const double*, const double*, size_t, size_t, float*);
+
+	//acc = acc*(1-t) + w[i]*t^i, same scheme as BezierCurve::calcBernsteinPoint
+	void evaluateScalar(const float* wx, const float* wy, const size_t count, const float* ts, const size_t n, glm::vec2* out) {
+		for(size_t j=0;j<n;j++) {
+			const float t = ts[j];
+			const float s = 1.0f-t;
+			float x = wx[0];
+			float y = wy[0];
+			float tn = 1.0f;
+			for(size_t i=1;i<count;i++) {
+				tn *= t;
+				x = x*s + wx[i]*tn;
+				y = y*s + wy[i]*tn;
+			}
+			out[j] = {x,y};
+		}
+	}
+
+#ifdef BEZIER_BATCH_X86
+	void evaluateSSE(const float* wx, const float* wy, const size_t count, const float* ts, const size_t n, glm::vec2* out) {
+		const __m128 one = _mm_set1_ps(1.0f);
+		size_t j = 0;
+		for(;j+4<=n;j+=4) {
+			const __m128 t = _mm_loadu_ps(ts+j);
+			const __m128 s = _mm_sub_ps(one,t);
+			__m128 x = _mm_set1_ps(wx[0]);
+			__m128 y = _mm_set1_ps(wy[0]);
+			__m128 tn = one;
+			for(size_t i=1;i<count;i++) {
+				tn = _mm_mul_ps(tn,t);
+				x = _mm_add_ps(_mm_mul_ps(x,s),_mm_mul_ps(_mm_set1_ps(wx[i]),tn));
+				y = _mm_add_ps(_mm_mul_ps(y,s),_mm_mul_ps(_mm_set1_ps(wy[i]),tn));
+			}
+			float* dst = &out[j].x;
+			_mm_storeu_ps(dst,_mm_unpacklo_ps(x,y));
+			_mm_storeu_ps(dst+4,_mm_unpackhi_ps(x,y));
+		}
+		evaluateScalar(wx,wy,count,ts+j,n-j,out+j);
+	}
+
+	BEZIER_TARGET("avx2,fma")
+	void evaluateAVX2(const float* wx, const float* wy, const size_t count, const float* ts, const size_t n, glm::vec2* out) {
+		const __m256 one = _mm256_set1_ps(1.0f);
+		size_t j = 0;
+		for(;j+8<=n;j+=8) {
+			const __m256 t = _mm256_loadu_ps(ts+j);
+			const __m256 s = _mm256_sub_ps(one,t);
+			__m256 x = _mm256_set1_ps(wx[0]);
+			__m256 y = _mm256_set1_ps(wy[0]);
+			__m256 tn = one;
+			for(size_t i=1;i<count;i++) {
+				tn = _mm256_mul_ps(tn,t);
+				x = _mm256_fmadd_ps(_mm256_set1_ps(wx[i]),tn,_mm256_mul_ps(x,s));
+				y = _mm256_fmadd_ps(_mm256_set1_ps(wy[i]),tn,_mm256_mul_ps(y,s));
+			}
+			//unpack works per 128 bit half: lo = p0 p1 | p4 p5, hi = p2 p3 | p6 p7
+			const __m256 lo = _mm256_unpacklo_ps(x,y);
+			const __m256 hi = _mm256_unpackhi_ps(x,y);
+			float* dst = &out[j].x;
+			_mm256_storeu_ps(dst,_mm256_permute2f128_ps(lo,hi,0x20));
+			_mm256_storeu_ps(dst+8,_mm256_permute2f128_ps(lo,hi,0x31));
+		}
+		evaluateScalar(wx,wy,count,ts+j,n-j,out+j);
+	}
+
+	BEZIER_TARGET("avx512f")
+	void evaluateAVX512(const float* wx, const float* wy, const size_t count, const float* ts, const size_t n, glm::vec2* out) {
+		const __m512 one = _mm512_set1_ps(1.0f);
+		const __m512i interleaveLo = _mm512_setr_epi32(0,16,1,17,2,18,3,19,4,20,5,21,6,22,7,23);
+		const __m512i interleaveHi = _mm512_setr_epi32(8,24,9,25,10,26,11,27,12,28,13,29,14,30,15,31);
+		size_t j = 0;
+		for(;j+16<=n;j+=16) {
+			const __m512 t = _mm512_loadu_ps(ts+j);
+			const __m512 s = _mm512_sub_ps(one,t);
+			__m512 x = _mm512_set1_ps(wx[0]);
+			__m512 y = _mm512_set1_ps(wy[0]);
+			__m512 tn = one;
+			for(size_t i=1;i<count;i++) {
+				tn = _mm512_mul_ps(tn,t);
+				x = _mm512_fmadd_ps(_mm512_set1_ps(wx[i]),tn,_mm512_mul_ps(x,s));
+				y = _mm512_fmadd_ps(_mm512_set1_ps(wy[i]),tn,_mm512_mul_ps(y,s));
+			}
+			float* dst = &out[j].x;
+			_mm512_storeu_ps(dst,_mm512_permutex2var_ps(x,interleaveLo,y));
+			_mm512_storeu_ps(dst+16,_mm512_permutex2var_ps(x,interleaveHi,y));
+		}
+		evaluateAVX2(wx,wy,count,ts+j,n-j,out+j);
+	}
+#endif
+
+	//rows of the 16 elements of a block from c, summed in double and rounded once
+	template<size_t Rows>
+	void seedColumn(const double* weights, const double* values, const size_t width, const size_t c, float (&rows)[Rows][16]) {
+		for(size_t m=0;m<Rows;m++) {
+			double sum[16] = {};
+			for(size_t j=m;j<Rows;j++) {
+				const double* w = weights+(m*Rows+j)*width+c;
+				const double* v = values+j*width+c;
+				for(size_t e=0;e<16;e++) {
+					sum[e] += w[e]*v[e];
+				}
+			}
+			for(size_t e=0;e<16;e++) {
+				rows[m][e] = static_cast<float>(sum[e]);
+			}
+		}
+	}
+
+	template<size_t Rows>
+	void stepForwardScalar(const double* weights, const double* values, const size_t width, const size_t steps, float* out) {
+		for(size_t c=0;c<width;c+=16) {
+			float rows[Rows][16];
+			seedColumn<Rows>(weights,values,width,c,rows);
+			float* block = out+c;
+			for(size_t s=0;s<steps;s++) {
+				std::memcpy(block,rows[0],sizeof(rows[0]));
+				for(size_t m=0;m+1<Rows;m++) {
+					for(size_t e=0;e<16;e++) {
+						rows[m][e] += rows[m+1][e];
+					}
+				}
+				block += width;
+			}
+		}
+	}
+
+#ifdef BEZIER_BATCH_X86
+	//each step only depends on the one before it, the rows of a column stay in registers for all of them
+	template<size_t Rows>
+	void stepForwardSSE(const double* weights, const double* values, const size_t width, const size_t steps, float* out) {
+		for(size_t c=0;c<width;c+=16) {
+			__m128 v[Rows][4];
+			for(size_t m=0;m<Rows;m++) {
+				__m128d sum[8];
+				for(size_t q=0;q<8;q++) {
+					sum[q] = _mm_setzero_pd();
+				}
+				for(size_t j=m;j<Rows;j++) {
+					const double* w = weights+(m*Rows+j)*width+c;
+					const double* v = values+j*width+c;
+					for(size_t q=0;q<8;q++) {
+						sum[q] = _mm_add_pd(sum[q],_mm_mul_pd(_mm_loadu_pd(w+2*q),_mm_loadu_pd(v+2*q)));
+					}
+				}
+				for(size_t q=0;q<4;q++) {
+					v[m][q] = _mm_movelh_ps(_mm_cvtpd_ps(sum[2*q]),_mm_cvtpd_ps(sum[2*q+1]));
+				}
+			}
+			float* block = out+c;
+			for(size_t s=0;s<steps;s++) {
+				for(size_t q=0;q<4;q++) {
+					_mm_storeu_ps(block+4*q,v[0][q]);
+				}
+				for(size_t m=0;m+1<Rows;m++) {
+					for(size_t q=0;q<4;q++) {
+						v[m][q] = _mm_add_ps(v[m][q],v[m+1][q]);
+					}
+				}
+				block += width;
+			}
+		}
+	}
+
+	template<size_t Rows>
+	BEZIER_TARGET("avx2,fma")
+	void stepForwardAVX2(const double* weights, const double* values, const size_t width, const size_t steps, float* out) {
+		for(size_t c=0;c<width;c+=16) {
+			__m256 v[Rows][2];
+			for(size_t m=0;m<Rows;m++) {
+				__m256d sum[4];
+				for(size_t q=0;q<4;q++) {
+					sum[q] = _mm256_setzero_pd();
+				}
+				for(size_t j=m;j<Rows;j++) {
+					const double* w = weights+(m*Rows+j)*width+c;
+					const double* v = values+j*width+c;
+					for(size_t q=0;q<4;q++) {
+						sum[q] = _mm256_fmadd_pd(_mm256_loadu_pd(w+4*q),_mm256_loadu_pd(v+4*q),sum[q]);
+					}
+				}
+				for(size_t q=0;q<2;q++) {
+					v[m][q] = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm256_cvtpd_ps(sum[2*q])),_mm256_cvtpd_ps(sum[2*q+1]),1);
+				}
+			}
+			float* block = out+c;
+			for(size_t s=0;s<steps;s++) {
+				_mm256_storeu_ps(block,v[0][0]);
+				_mm256_storeu_ps(block+8,v[0][1]);
+				for(size_t m=0;m+1<Rows;m++) {
+					v[m][0] = _mm256_add_ps(v[m][0],v[m+1][0]);
+					v[m][1] = _mm256_add_ps(v[m][1],v[m+1][1]);
+				}
+				block += width;
+			}
+		}
+	}
+
+	//two registers a row, one would leave every step waiting on the add before it
+	template<size_t Rows>
+	BEZIER_TARGET("avx512f")
+	void stepForwardAVX512(const double* weights, const double* values, const size_t width, const size_t steps, float* out) {
+		for(size_t c=0;c<width;c+=32) {
+			__m512 v[Rows][2];
+			for(size_t m=0;m<Rows;m++) {
+				__m512d sum[4];
+				for(size_t q=0;q<4;q++) {
+					sum[q] = _mm512_setzero_pd();
+				}
+				for(size_t j=m;j<Rows;j++) {
+					const double* w = weights+(m*Rows+j)*width+c;
+					const double* v = values+j*width+c;
+					for(size_t q=0;q<4;q++) {
+						sum[q] = _mm512_fmadd_pd(_mm512_loadu_pd(w+8*q),_mm512_loadu_pd(v+8*q),sum[q]);
+					}
+				}
+				for(size_t q=0;q<2;q++) {
+					const __m512d low = _mm512_castps_pd(_mm512_castps256_ps512(_mm512_cvtpd_ps(sum[2*q])));
+					v[m][q] = _mm512_castpd_ps(_mm512_insertf64x4(low,_mm256_castps_pd(_mm512_cvtpd_ps(sum[2*q+1])),1));
+				}
+			}
+			float* block = out+c;
+			for(size_t s=0;s<steps;s++) {
+				_mm512_storeu_ps(block,v[0][0]);
+				_mm512_storeu_ps(block+16,v[0][1]);
+				for(size_t m=0;m+1<Rows;m++) {
+					v[m][0] = _mm512_add_ps(v[m][0],v[m+1][0]);
+					v[m][1] = _mm512_add_ps(v[m][1],v[m+1][1]);
+				}
+				block += width;
+			}
+		}
+	}
+#endif
+
+	template<size_t Rows>
+	StepKernel stepKernelFor(const BezierBatch::InstructionSet set) {
+		switch(set) {
+#ifdef BEZIER_BATCH_X86
+		case BezierBatch::InstructionSet::AVX512:
+			return stepForwardAVX512<Rows>;
+		case BezierBatch::InstructionSet::AVX2:
+			return stepForwardAVX2<Rows>;
+		case BezierBatch::InstructionSet::SSE:
+			return stepForwardSSE<Rows>;
+#endif
+		default:
+			return stepForwardScalar<Rows>;
+		}
+	}
+
+	//kernels by row count, the rows are a template parameter so they can be held in registers
+	template<size_t... R>
+	std::array<StepKernel,BezierBatch::maxStepRows+1> stepKernelsFor(const BezierBatch::InstructionSet set, std::index_sequence<R...>) {
+		return {nullptr,nullptr,stepKernelFor<R+2>(set)...};
+	}
+	std::array<StepKernel,BezierBatch::maxStepRows+1> stepKernelsFor(const BezierBatch::InstructionSet set) {
+		return stepKernelsFor(set,std::make_index_sequence<BezierBatch::maxStepRows-1>());
+	}
+
+	Kernel kernelFor(const BezierBatch::InstructionSet set) {
+		switch(set) {
+#ifdef BEZIER_BATCH_X86
+		case BezierBatch::InstructionSet::AVX512:
+			return evaluateAVX512;
+		case BezierBatch::InstructionSet::AVX2:
+			return evaluateAVX2;
+		case BezierBatch::InstructionSet::SSE:
+			return evaluateSSE;
+#endif
+		default:
+			return evaluateScalar;
+		}
+	}
+
+	BezierBatch::InstructionSet detected = BezierBatch::Detect();
+	BezierBatch::InstructionSet active = detected;
+	Kernel activeKernel = kernelFor(active);
+	std::array<StepKernel,BezierBatch::maxStepRows+1> activeStepKernels = stepKernelsFor(active);
+}
+
+BezierBatch::InstructionSet BezierBatch::Detect() {
+#if defined(BEZIER_BATCH_X86) && defined(_MSC_VER)
+	int info[4];
+	__cpuid(info,0);
+	const int maxLeaf = info[0];
+	__cpuid(info,1);
+	const bool fma = info[2] & (1<<12);
+	const bool osxsave = info[2] & (1<<27);
+	const unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+	const bool ymmState = (xcr0 & 0x06) == 0x06;
+	const bool zmmState = (xcr0 & 0xE6) == 0xE6;
+	bool avx2 = false;
+	bool avx512 = false;
+	if(maxLeaf>=7) {
+		__cpuidex(info,7,0);
+		avx2 = info[1] & (1<<5);
+		avx512 = info[1] & (1<<16);
+	}
+	if(avx512 && fma && zmmState) {
+		return InstructionSet::AVX512;
+	}
+	if(avx2 && fma && ymmState) {
+		return InstructionSet::AVX2;
+	}
+	return InstructionSet::SSE;
+#elif defined(BEZIER_BATCH_X86)
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx512f")) {
+		return InstructionSet::AVX512;
+	}
+	if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+		return InstructionSet::AVX2;
+	}
+	if(__builtin_cpu_supports("sse2")) {
+		return InstructionSet::SSE;
+	}
+	return InstructionSet::Scalar;
+#else
+	return InstructionSet::Scalar;
+#endif
+}
+
+BezierBatch::InstructionSet BezierBatch::Active() {
+	return active;
+}
+
+void BezierBatch::SetActive(const InstructionSet set) {
+	active = static_cast<int>(set) <= static_cast<int>(detected) ? set : detected;
+	activeKernel = kernelFor(active);
+	activeStepKernels = stepKernelsFor(active);
+}
+
+const char* BezierBatch::Name(const InstructionSet set) {
+	switch(set) {
+	case InstructionSet::SSE:
+		return "SSE";
+	case InstructionSet::AVX2:
+		return "AVX2";
+	case InstructionSet::AVX512:
+		return "AVX-512";
+	default:
+		return "Scalar";
+	}
+}
+
+void BezierBatch::Evaluate(const float* wx, const float* wy, const size_t count, const float* ts, const size_t n, glm::vec2* out) {
+	if(count==0) {
+		return;
+	}
+#ifdef BEZIER_BATCH_X86
+	//t^i and (1-t)^i go denormal for high degrees near the ends, those lanes are far below float precision of the sum
+	//but slow every instruction down, so they are flushed to zero for the kernel and the caller's mode is restored after
+	const unsigned int csr = _mm_getcsr();
+	_mm_setcsr(csr | 0x8040);//FTZ | DAZ
+	activeKernel(wx,wy,count,ts,n,out);
+	_mm_setcsr(csr);
+#else
+	activeKernel(wx,wy,count,ts,n,out);
+#endif
+}
+
+void BezierBatch::StepForward(const double* weights, const double* values, const size_t rows, const size_t width, const size_t steps, float* out) {
+	if(rows<2 || rows>maxStepRows) {
+		return;
+	}
+	activeStepKernels[rows](weights,values,width,steps,out);
+}
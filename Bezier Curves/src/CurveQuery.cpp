@@ -0,0 +1,359 @@
+#include "../include/CurveQuery.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <limits>
+
+namespace {
+	constexpr size_t localPoints = 16;
+	float cross(const glm::vec2 a, const glm::vec2 b) {
+		return a.x*b.y-a.y*b.x;
+	}
+	float boxDistance2(const BoundingBox& box, const glm::vec2 q) {
+		const glm::vec2 d = glm::max(glm::max(box.min-q, q-box.max), glm::vec2(0.0f));
+		return glm::dot(d, d);
+	}
+	float boxSize(const BoundingBox& box) {
+		return (box.max.x-box.min.x)+(box.max.y-box.min.y);
+	}
+	//de Casteljau at 1/2, both halves have as many control points as p
+	void split(const std::vector<glm::vec2>& p, std::vector<glm::vec2>& left, std::vector<glm::vec2>& right) {
+		const size_t count = p.size();
+		std::vector<glm::vec2> level(p);
+		left.resize(count);
+		right.resize(count);
+		for(size_t c=count;c>0;c--) {
+			left[count-c] = level[0];
+			right[c-1] = level[c-1];
+			for(size_t i=0;i+1<c;i++) {
+				level[i] = (level[i]+level[i+1])*0.5f;
+			}
+		}
+	}
+}
+
+CurveQuery::CurveQuery(const float tolerance):tolerance(tolerance) {}
+
+bool CurveQuery::isFlat(const glm::vec2* p, const size_t count) const {
+	const glm::vec2 chord = p[count-1]-p[0];
+	const float length2 = glm::dot(chord, chord);
+	for(size_t i=1;i+1<count;i++) {
+		const glm::vec2 d = p[i]-p[0];
+		const float u = length2>0.0f ? std::clamp(glm::dot(d, chord)/length2, 0.0f, 1.0f) : 0.0f;
+		const glm::vec2 off = d-chord*u;
+		if(glm::dot(off, off)>tolerance*tolerance) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void CurveQuery::build(const uint32_t node, std::vector<glm::vec2>& p, const float t0, const float t1, const int depth) {
+	BoundingBox box;
+	for(const glm::vec2 point : p) {
+		box.Extend(point);
+	}
+	nodes[node].box = box;
+	nodes[node].t0 = t0;
+	nodes[node].t1 = t1;
+	const bool flat = p.size()<3 || isFlat(p.data(), p.size());
+	if(flat || depth>=maxDepth) {
+		nodes[node].flat = flat;
+		nodes[node].points = static_cast<uint32_t>(leafPoints.size());
+		leafPoints.insert(leafPoints.end(), p.begin(), p.end());
+		return;
+	}
+	//the children are appended before recursing, nodes may move so everything goes through indices
+	const uint32_t children = static_cast<uint32_t>(nodes.size());
+	nodes.resize(nodes.size()+2);
+	nodes[node].children = static_cast<int32_t>(children);
+	std::vector<glm::vec2> left;
+	std::vector<glm::vec2> right;
+	split(p, left, right);
+	const float middle = (t0+t1)*0.5f;
+	build(children, left, t0, middle, depth+1);
+	build(children+1, right, middle, t1, depth+1);
+}
+
+size_t CurveQuery::AddCurve(const glm::vec2* points, const size_t count) {
+	Curve curve;
+	curve.root = static_cast<uint32_t>(nodes.size());
+	curve.pointCount = static_cast<uint32_t>(count);
+	nodes.emplace_back();
+	std::vector<glm::vec2> p(points, points+count);
+	build(curve.root, p, 0.0f, 1.0f, 0);
+	curves.push_back(curve);
+	return curves.size()-1;
+}
+
+void CurveQuery::Clear() {
+	nodes.clear();
+	leafPoints.clear();
+	curves.clear();
+}
+
+size_t CurveQuery::CurveCount() const {
+	return curves.size();
+}
+
+size_t CurveQuery::NodeCount() const {
+	return nodes.size();
+}
+
+float CurveQuery::Tolerance() const {
+	return tolerance;
+}
+
+void CurveQuery::evaluate(const glm::vec2* p, const size_t count, const float u, glm::vec2& pos, glm::vec2& d1, glm::vec2& d2, std::vector<glm::vec2>& scratch) {
+	if(count<3) {
+		pos = count==2 ? p[0]+(p[1]-p[0])*u : p[0];
+		d1 = count==2 ? p[1]-p[0] : glm::vec2(0.0f);
+		d2 = glm::vec2(0.0f);
+		return;
+	}
+	//low degrees stay on the stack
+	glm::vec2 local[localPoints];
+	glm::vec2* q = local;
+	if(count>localPoints) {
+		scratch.resize(count);
+		q = scratch.data();
+	}
+	std::copy(p, p+count, q);
+	for(size_t c=count;c>3;c--) {
+		for(size_t i=0;i+1<c;i++) {
+			q[i] = q[i]+(q[i+1]-q[i])*u;
+		}
+	}
+	const float n = static_cast<float>(count-1);
+	d2 = (q[2]-q[1]*2.0f+q[0])*(n*(n-1.0f));
+	const glm::vec2 r0 = q[0]+(q[1]-q[0])*u;
+	const glm::vec2 r1 = q[1]+(q[2]-q[1])*u;
+	d1 = (r1-r0)*n;
+	pos = r0+(r1-r0)*u;
+}
+
+//Newton steps on the squared distance from the chord projection, the leaf's end points are curve points too
+void CurveQuery::refineLeaf(const Curve& curve, const Node& leaf, const glm::vec2 q, Scratch& scratch, float& best, float& t, glm::vec2& pos) const {
+	const glm::vec2* p = leafPoints.data()+leaf.points;
+	const size_t count = curve.pointCount;
+	const glm::vec2 chord = p[count-1]-p[0];
+	const float length2 = glm::dot(chord, chord);
+	float u = length2>0.0f ? std::clamp(glm::dot(q-p[0], chord)/length2, 0.0f, 1.0f) : 0.0f;
+	//a flat leaf is within tolerance of its chord, which bounds it tighter than its box
+	const float chordDistance = glm::length(p[0]+chord*u-q);
+	if(leaf.flat && chordDistance>tolerance && (chordDistance-tolerance)*(chordDistance-tolerance)>=best) {
+		return;
+	}
+	glm::vec2 point, d1, d2;
+	for(int i=0;i<newtonIterations;i++) {
+		evaluate(p, count, u, point, d1, d2, scratch.points);
+		const glm::vec2 offset = point-q;
+		const float slope = glm::dot(d1, d1)+glm::dot(offset, d2);
+		if(slope<=0.0f) {
+			break;
+		}
+		u = std::clamp(u-glm::dot(offset, d1)/slope, 0.0f, 1.0f);
+	}
+	evaluate(p, count, u, point, d1, d2, scratch.points);
+	const float candidates[3] = {u, 0.0f, 1.0f};
+	const glm::vec2 points[3] = {point, p[0], p[count-1]};
+	for(int i=0;i<3;i++) {
+		const glm::vec2 offset = points[i]-q;
+		const float distance2 = glm::dot(offset, offset);
+		if(distance2<best) {
+			best = distance2;
+			t = leaf.t0+(leaf.t1-leaf.t0)*candidates[i];
+			pos = points[i];
+		}
+	}
+}
+
+//depth first with the nearer child first, subtrees whose box is farther than the best point so far are skipped
+void CurveQuery::closestPoint(const Curve& curve, const glm::vec2 q, Scratch& scratch, float& t, glm::vec2& pos, float& distance) const {
+	t = 0.0f;
+	pos = glm::vec2(std::numeric_limits<float>::quiet_NaN());
+	if(curve.pointCount==0) {
+		distance = std::numeric_limits<float>::infinity();
+		return;
+	}
+	float best = FLT_MAX;
+	scratch.stack.clear();
+	scratch.stack.push_back(curve.root);
+	while(!scratch.stack.empty()) {
+		const Node& node = nodes[scratch.stack.back()];
+		scratch.stack.pop_back();
+		if(boxDistance2(node.box, q)>=best) {
+			continue;
+		}
+		if(node.children<0) {
+			refineLeaf(curve, node, q, scratch, best, t, pos);
+			continue;
+		}
+		const uint32_t first = static_cast<uint32_t>(node.children);
+		const bool firstNearer = boxDistance2(nodes[first].box, q)<=boxDistance2(nodes[first+1].box, q);
+		scratch.stack.push_back(firstNearer ? first+1 : first);
+		scratch.stack.push_back(firstNearer ? first : first+1);
+	}
+	distance = std::sqrt(best);
+}
+
+//the chords' intersection starts a 2D Newton iteration on the two pieces, hits outside of the leaves are left to their neighbours
+void CurveQuery::intersectLeaves(const Curve& a, const Node& leafA, const Curve& b, const Node& leafB, Scratch& scratch, std::vector<Hit>& hits) const {
+	const glm::vec2* pa = leafPoints.data()+leafA.points;
+	const glm::vec2* pb = leafPoints.data()+leafB.points;
+	const size_t countA = a.pointCount;
+	const size_t countB = b.pointCount;
+	const glm::vec2 r = pa[countA-1]-pa[0];
+	const glm::vec2 s = pb[countB-1]-pb[0];
+	const float denominator = cross(r, s);
+	if(std::abs(denominator)<=1e-12f*glm::length(r)*glm::length(s)) {//parallel chords, overlapping curves have no isolated hits
+		return;
+	}
+	const glm::vec2 d = pb[0]-pa[0];
+	float u = cross(d, s)/denominator;
+	float v = cross(d, r)/denominator;
+	//the chords are only within tolerance of the pieces, a hit near a leaf's end can put the chords' one slightly past it
+	if(u<-0.5f || u>1.5f || v<-0.5f || v>1.5f) {
+		return;
+	}
+	u = std::clamp(u, 0.0f, 1.0f);
+	v = std::clamp(v, 0.0f, 1.0f);
+	glm::vec2 posA, dA, d2A, posB, dB, d2B;
+	for(int i=0;i<2*newtonIterations;i++) {
+		evaluate(pa, countA, u, posA, dA, d2A, scratch.points);
+		evaluate(pb, countB, v, posB, dB, d2B, scratch.points);
+		const glm::vec2 f = posA-posB;
+		const float det = cross(dB, dA);
+		if(std::abs(det)<=FLT_MIN) {
+			break;
+		}
+		//dA*du - dB*dv = -f
+		u = std::clamp(u+cross(f, dB)/det, 0.0f, 1.0f);
+		v = std::clamp(v+cross(f, dA)/det, 0.0f, 1.0f);
+	}
+	evaluate(pa, countA, u, posA, dA, d2A, scratch.points);
+	evaluate(pb, countB, v, posB, dB, d2B, scratch.points);
+	const glm::vec2 f = posA-posB;
+	if(glm::dot(f, f)>tolerance*tolerance*0.01f) {
+		return;
+	}
+	hits.push_back({leafA.t0+(leafA.t1-leafA.t0)*u, leafB.t0+(leafB.t1-leafB.t0)*v, (posA+posB)*0.5f});
+}
+
+//pairs of pieces whose boxes overlap, the larger piece of a pair is the one split further
+void CurveQuery::intersect(const Curve& a, const Curve& b, Scratch& scratch, std::vector<Hit>& hits) const {
+	const size_t firstHit = hits.size();
+	if(&a==&b || a.pointCount<2 || b.pointCount<2) {
+		return;
+	}
+	scratch.pairStack.clear();
+	scratch.pairStack.push_back(a.root);
+	scratch.pairStack.push_back(b.root);
+	while(!scratch.pairStack.empty()) {
+		const Node& nodeB = nodes[scratch.pairStack.back()];
+		scratch.pairStack.pop_back();
+		const Node& nodeA = nodes[scratch.pairStack.back()];
+		scratch.pairStack.pop_back();
+		if(!nodeA.box.Intersects(nodeB.box)) {
+			continue;
+		}
+		if(nodeA.children<0 && nodeB.children<0) {
+			intersectLeaves(a, nodeA, b, nodeB, scratch, hits);
+			continue;
+		}
+		const uint32_t indexA = static_cast<uint32_t>(&nodeA-nodes.data());
+		const uint32_t indexB = static_cast<uint32_t>(&nodeB-nodes.data());
+		if(nodeB.children<0 || (nodeA.children>=0 && boxSize(nodeA.box)>=boxSize(nodeB.box))) {
+			for(uint32_t child=0;child<2;child++) {
+				scratch.pairStack.push_back(static_cast<uint32_t>(nodeA.children)+child);
+				scratch.pairStack.push_back(indexB);
+			}
+		}else {
+			for(uint32_t child=0;child<2;child++) {
+				scratch.pairStack.push_back(indexA);
+				scratch.pairStack.push_back(static_cast<uint32_t>(nodeB.children)+child);
+			}
+		}
+	}
+	//neighbouring leaves find the hit on their shared end both
+	std::sort(hits.begin()+firstHit, hits.end(), [](const Hit& l, const Hit& r) { return l.tA<r.tA; });
+	const auto duplicate = [this](const Hit& l, const Hit& r) {
+		const glm::vec2 d = l.pos-r.pos;
+		return glm::dot(d, d)<=tolerance*tolerance;
+	};
+	hits.erase(std::unique(hits.begin()+firstHit, hits.end(), duplicate), hits.end());
+}
+
+void CurveQuery::forBatches(const size_t n, ThreadPool* pool, const std::function<void(size_t,size_t,size_t)>& task) {
+	const size_t batches = (n+batchSize-1)/batchSize;
+	if(pool==nullptr || batches<2) {
+		for(size_t batch=0;batch<batches;batch++) {
+			task(batch, batch*batchSize, std::min(batchSize, n-batch*batchSize));
+		}
+		return;
+	}
+	for(size_t batch=0;batch<batches;batch++) {
+		pool->Submit([&task,batch,n] { task(batch, batch*batchSize, std::min(batchSize, n-batch*batchSize)); });
+	}
+	pool->Wait();
+}
+
+void CurveQuery::ClosestPoints(const uint32_t* curveIndices, const glm::vec2* points, const size_t n, ClosestPointResults& out, ThreadPool* pool) const {
+	out.t.resize(n);
+	out.x.resize(n);
+	out.y.resize(n);
+	out.distance.resize(n);
+	const Curve empty;
+	forBatches(n, pool, [&](size_t, const size_t first, const size_t count) {
+		Scratch scratch;
+		for(size_t i=first;i<first+count;i++) {
+			const Curve& curve = curveIndices[i]<curves.size() ? curves[curveIndices[i]] : empty;
+			glm::vec2 pos;
+			closestPoint(curve, points[i], scratch, out.t[i], pos, out.distance[i]);
+			out.x[i] = pos.x;
+			out.y[i] = pos.y;
+		}
+	});
+}
+
+void CurveQuery::Intersect(const uint32_t* curvesA, const uint32_t* curvesB, const size_t n, IntersectionResults& out, ThreadPool* pool) const {
+	out.first.resize(n);
+	out.count.resize(n);
+	//every batch collects its own hits, they are put together in pair order afterwards
+	std::vector<std::vector<Hit>> batchHits((n+batchSize-1)/batchSize);
+	forBatches(n, pool, [&](const size_t batch, const size_t first, const size_t count) {
+		Scratch scratch;
+		std::vector<Hit>& hits = batchHits[batch];
+		for(size_t i=first;i<first+count;i++) {
+			out.first[i] = static_cast<uint32_t>(hits.size());
+			if(curvesA[i]<curves.size() && curvesB[i]<curves.size() && curvesA[i]!=curvesB[i]) {
+				intersect(curves[curvesA[i]], curves[curvesB[i]], scratch, hits);
+			}
+			out.count[i] = static_cast<uint32_t>(hits.size())-out.first[i];
+		}
+	});
+	size_t total = 0;
+	for(const std::vector<Hit>& hits : batchHits) {
+		total += hits.size();
+	}
+	out.tA.resize(total);
+	out.tB.resize(total);
+	out.x.resize(total);
+	out.y.resize(total);
+	size_t offset = 0;
+	for(size_t batch=0;batch<batchHits.size();batch++) {
+		const std::vector<Hit>& hits = batchHits[batch];
+		for(size_t i=0;i<hits.size();i++) {
+			out.tA[offset+i] = hits[i].tA;
+			out.tB[offset+i] = hits[i].tB;
+			out.x[offset+i] = hits[i].pos.x;
+			out.y[offset+i] = hits[i].pos.y;
+		}
+		const size_t last = std::min(n, (batch+1)*batchSize);
+		for(size_t i=batch*batchSize;i<last;i++) {
+			out.first[i] += static_cast<uint32_t>(offset);
+		}
+		offset += hits.size();
+	}
+}
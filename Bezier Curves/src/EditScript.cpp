@@ -0,0 +1,111 @@
+#include "../include/EditScript.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+namespace {
+	bool readCurve(std::istream& in, uint32_t& curve) {
+		std::string token;
+		if(!(in >> token)) {
+			return false;
+		}
+		if(token=="last") {
+			curve = EditScript::lastCurve;
+			return true;
+		}
+		char* end = nullptr;
+		const unsigned long value = std::strtoul(token.c_str(),&end,10);
+		curve = static_cast<uint32_t>(value);
+		return *end=='\0' && !token.empty() && token[0]!='-';
+	}
+}
+
+bool EditScript::Load(std::istream& in) {
+	frames.clear();
+	error.clear();
+	std::string line;
+	for(size_t lineNumber=1;std::getline(in,line);lineNumber++) {
+		const size_t comment = line.find('#');
+		if(comment!=std::string::npos) {
+			line.erase(comment);
+		}
+		std::istringstream words(line);
+		std::string command;
+		if(!(words >> command)) {
+			continue;
+		}
+		Step step;
+		size_t count = 1;
+		bool ok = true;
+		if(command=="drag") {
+			step.kind = Kind::Drag;
+			ok = readCurve(words,step.curve) && (words >> step.point >> step.value.x >> step.value.y >> count) && count>0;
+			if(ok) {
+				step.value /= static_cast<float>(count);
+			}
+		}else if(command=="insert") {
+			step.kind = Kind::Insert;
+			ok = readCurve(words,step.curve) && (words >> step.value.x >> step.value.y);
+		}else if(command=="curve") {
+			step.kind = Kind::NewCurve;
+		}else if(command=="precision") {
+			step.kind = Kind::Precision;
+			ok = (words >> step.factor) && step.factor>0.0f;
+		}else if(command=="wait") {
+			ok = static_cast<bool>(words >> count);
+		}else {
+			ok = false;
+		}
+		std::string rest;
+		if(!ok || (words >> rest)) {
+			frames.clear();
+			error = "line "+std::to_string(lineNumber)+": can't read \""+line+"\"";
+			return false;
+		}
+		frames.insert(frames.end(),count,step);
+	}
+	return true;
+}
+
+bool EditScript::Load(const std::string& path) {
+	std::ifstream file(path);
+	if(!file) {
+		frames.clear();
+		error = "can't open "+path;
+		return false;
+	}
+	return Load(file);
+}
+
+EditScript EditScript::Synthetic(const size_t frames, const size_t insertEvery, const size_t precisionEvery) {
+	//a second per point at 60 frames per second
+	constexpr size_t dragFrames = 60;
+	constexpr float radius = 40.0f;
+	const float step = 2.0f*3.14159265f/dragFrames;
+	EditScript script;
+	script.frames.resize(frames);
+	size_t precisionChanges = 0;
+	for(size_t i=0;i<frames;i++) {
+		Step& s = script.frames[i];
+		const size_t drag = i/dragFrames;
+		if(precisionEvery>0 && i%precisionEvery==precisionEvery-1) {
+			s.kind = Kind::Precision;
+			s.factor = precisionChanges++%2==0 ? 0.5f : 2.0f;
+		}else if(insertEvery>0 && i%insertEvery==insertEvery-1) {
+			//on a spiral through the middle of the default window
+			const float angle = 0.7f*static_cast<float>(i/insertEvery);
+			s.kind = Kind::Insert;
+			s.curve = static_cast<uint32_t>(drag);
+			s.value = glm::vec2(400.0f,300.0f)+(80.0f+static_cast<float>(i%200))*glm::vec2(std::cos(angle),std::sin(angle));
+		}else {
+			const float angle = step*static_cast<float>(i%dragFrames);
+			s.kind = Kind::Drag;
+			s.curve = static_cast<uint32_t>(drag);
+			s.point = static_cast<uint32_t>(drag);
+			s.value = radius*glm::vec2(std::cos(angle+step)-std::cos(angle),std::sin(angle+step)-std::sin(angle));
+		}
+	}
+	return script;
+}
@@ -0,0 +1,54 @@
+#include "../include/FrameBuffer.h"
+
+bool FrameBuffer::create(const GLsizei width, const GLsizei height) {
+	destroy();
+	this->width = width;
+	this->height = height;
+	glGenRenderbuffers(1, &colorBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+	glGenFramebuffers(1, &id);
+	glBindFramebuffer(GL_FRAMEBUFFER, id);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+	const bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER)==GL_FRAMEBUFFER_COMPLETE;
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	if(!complete) {
+		destroy();
+	}
+	return complete;
+}
+
+void FrameBuffer::destroy() {
+	if(id!=0) {
+		glDeleteFramebuffers(1, &id);
+		id = 0;
+	}
+	if(colorBuffer!=0) {
+		glDeleteRenderbuffers(1, &colorBuffer);
+		colorBuffer = 0;
+	}
+}
+
+void FrameBuffer::bind() const {
+	glBindFramebuffer(GL_FRAMEBUFFER, id);
+}
+
+void FrameBuffer::unbind() {
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void FrameBuffer::readPixels(std::vector<uint8_t>& rgba) const {
+	rgba.resize(static_cast<size_t>(width)*height*4);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, id);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, rgba.data());
+}
+
+GLsizei FrameBuffer::getWidth() const {
+	return width;
+}
+
+GLsizei FrameBuffer::getHeight() const {
+	return height;
+}
@@ -0,0 +1,73 @@
+#include "../include/GLExt.h"
+
+#include <cstring>
+
+namespace {
+	typedef void (APIENTRYP BufferStorageProc)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+	typedef void (APIENTRYP ProgramParameteriProc)(GLuint program, GLenum name, GLint value);
+	typedef void (APIENTRYP GetProgramBinaryProc)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+	typedef void (APIENTRYP ProgramBinaryProc)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+	BufferStorageProc bufferStorageProc = nullptr;
+	ProgramParameteriProc programParameteriProc = nullptr;
+	GetProgramBinaryProc getProgramBinaryProc = nullptr;
+	ProgramBinaryProc programBinaryProc = nullptr;
+}
+
+void GLExt::load(GLADloadproc loader) {
+	GLint major = 0;
+	GLint minor = 0;
+	glGetIntegerv(GL_MAJOR_VERSION, &major);
+	glGetIntegerv(GL_MINOR_VERSION, &minor);
+	bufferStorageProc = nullptr;
+	if(major>4 || (major==4 && minor>=4) || hasExtension("GL_ARB_buffer_storage")) {
+		bufferStorageProc = reinterpret_cast<BufferStorageProc>(loader("glBufferStorage"));
+	}
+	programParameteriProc = nullptr;
+	getProgramBinaryProc = nullptr;
+	programBinaryProc = nullptr;
+	GLint binaryFormats = 0;
+	if(major>4 || (major==4 && minor>=1) || hasExtension("GL_ARB_get_program_binary")) {
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &binaryFormats);
+	}
+	if(binaryFormats>0) {//drivers without a binary format have the entry points but can't save anything
+		programParameteriProc = reinterpret_cast<ProgramParameteriProc>(loader("glProgramParameteri"));
+		getProgramBinaryProc = reinterpret_cast<GetProgramBinaryProc>(loader("glGetProgramBinary"));
+		programBinaryProc = reinterpret_cast<ProgramBinaryProc>(loader("glProgramBinary"));
+	}
+}
+
+bool GLExt::hasBufferStorage() {
+	return bufferStorageProc!=nullptr;
+}
+
+void GLExt::bufferStorage(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags) {
+	bufferStorageProc(target, size, data, flags);
+}
+
+bool GLExt::hasProgramBinary() {
+	return programParameteriProc!=nullptr && getProgramBinaryProc!=nullptr && programBinaryProc!=nullptr;
+}
+
+void GLExt::programParameteri(GLuint program, GLenum name, GLint value) {
+	programParameteriProc(program, name, value);
+}
+
+void GLExt::getProgramBinary(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary) {
+	getProgramBinaryProc(program, bufSize, length, binaryFormat, binary);
+}
+
+void GLExt::programBinary(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length) {
+	programBinaryProc(program, binaryFormat, binary, length);
+}
+
+bool GLExt::hasExtension(const char* name) {
+	GLint count = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+	for(GLint i=0;i<count;i++) {
+		const GLubyte* extension = glGetStringi(GL_EXTENSIONS, i);
+		if(extension!=nullptr && std::strcmp(reinterpret_cast<const char*>(extension), name)==0) {
+			return true;
+		}
+	}
+	return false;
+}
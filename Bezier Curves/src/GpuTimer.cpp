@@ -0,0 +1,88 @@
+#include "../include/GpuTimer.h"
+
+void GpuTimer::create() {
+	GLint bits = 0;
+	glGetQueryiv(GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &bits);
+	available = bits>0;
+	if(!available) {
+		return;
+	}
+	for(int i=0;i<latency;i++) {
+		glGenQueries(maxQueries, queries[i]);
+		queryCount[i] = 0;
+		rangeCount[i] = 0;
+	}
+	current = 0;
+	openCount = 0;
+}
+
+void GpuTimer::destroy() {
+	if(!available) {
+		return;
+	}
+	for(int i=0;i<latency;i++) {
+		glDeleteQueries(maxQueries, queries[i]);
+	}
+	available = false;
+}
+
+bool GpuTimer::isAvailable() const {
+	return available;
+}
+
+void GpuTimer::beginFrame(uint64_t frame) {
+	if(!available) {
+		return;
+	}
+	current = (current+1)%latency;
+	for(int i=0;i<rangeCount[current];i++) {
+		const Range& range = ranges[current][i];
+		if(range.last<0) {
+			continue;
+		}
+		GLint ready = 0;
+		glGetQueryObjectiv(queries[current][range.last], GL_QUERY_RESULT_AVAILABLE, &ready);
+		if(!ready) {//dropped rather than waited for
+			continue;
+		}
+		GLuint64 start = 0;
+		GLuint64 stop = 0;
+		glGetQueryObjectui64v(queries[current][range.first], GL_QUERY_RESULT, &start);
+		glGetQueryObjectui64v(queries[current][range.last], GL_QUERY_RESULT, &stop);
+		Profiler::AddGpuTime(frames[current], range.section, static_cast<double>(stop-start)/1000.0);
+	}
+	queryCount[current] = 0;
+	rangeCount[current] = 0;
+	openCount = 0;
+	frames[current] = frame;
+}
+
+void GpuTimer::begin(size_t section) {
+	if(!available || queryCount[current]+2>maxQueries) {
+		open[openCount++] = -1;
+		return;
+	}
+	const int range = rangeCount[current]++;
+	ranges[current][range] = {section, queryCount[current]++, -1};
+	queryCount[current]++;//the end query is reserved with the begin one, so a begun range can always end
+	glQueryCounter(queries[current][ranges[current][range].first], GL_TIMESTAMP);
+	open[openCount++] = range;
+}
+
+void GpuTimer::end() {
+	const int range = open[--openCount];
+	if(range<0) {
+		return;
+	}
+	Range& r = ranges[current][range];
+	r.last = r.first+1;
+	glQueryCounter(queries[current][r.last], GL_TIMESTAMP);
+}
+
+GpuTimer::Scope::Scope(GpuTimer& timer, size_t section):timer(timer) {
+	timer.begin(section);
+}
+
+GpuTimer::Scope::~Scope() {
+	timer.end();
+}
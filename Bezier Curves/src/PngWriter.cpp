@@ -0,0 +1,115 @@
+#include "../include/PngWriter.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+namespace {
+	const uint32_t* crcTable() {
+		static const std::vector<uint32_t> table = [] {
+			std::vector<uint32_t> t(256);
+			for(uint32_t i=0;i<256;i++) {
+				uint32_t c = i;
+				for(int k=0;k<8;k++) {
+					c = (c&1) ? 0xEDB88320u^(c>>1) : c>>1;
+				}
+				t[i] = c;
+			}
+			return t;
+		}();
+		return table.data();
+	}
+
+	uint32_t crc32(const uint8_t* data, const size_t size, uint32_t crc = 0xFFFFFFFFu) {
+		const uint32_t* table = crcTable();
+		for(size_t i=0;i<size;i++) {
+			crc = table[(crc^data[i])&0xFF]^(crc>>8);
+		}
+		return crc;
+	}
+
+	void put32(std::vector<uint8_t>& out, const uint32_t value) {
+		out.push_back(static_cast<uint8_t>(value>>24));
+		out.push_back(static_cast<uint8_t>(value>>16));
+		out.push_back(static_cast<uint8_t>(value>>8));
+		out.push_back(static_cast<uint8_t>(value));
+	}
+
+	//length, type, data and the crc of type and data
+	void writeChunk(std::ofstream& file, const char type[4], const std::vector<uint8_t>& data) {
+		std::vector<uint8_t> head;
+		put32(head,static_cast<uint32_t>(data.size()));
+		head.insert(head.end(),type,type+4);
+		uint32_t crc = crc32(head.data()+4,4);
+		crc = crc32(data.data(),data.size(),crc)^0xFFFFFFFFu;
+		std::vector<uint8_t> tail;
+		put32(tail,crc);
+		file.write(reinterpret_cast<const char*>(head.data()),head.size());
+		file.write(reinterpret_cast<const char*>(data.data()),data.size());
+		file.write(reinterpret_cast<const char*>(tail.data()),tail.size());
+	}
+}
+
+bool PngWriter::Write(const std::string& path, const uint8_t* rgba, const uint32_t width, const uint32_t height, const bool bottomUp) {
+	std::ofstream file(path,std::ios::binary);
+	if(!file) {
+		return false;
+	}
+	static const uint8_t signature[8] = {0x89,'P','N','G','\r','\n',0x1A,'\n'};
+	file.write(reinterpret_cast<const char*>(signature),sizeof(signature));
+
+	std::vector<uint8_t> header;
+	put32(header,width);
+	put32(header,height);
+	header.push_back(8);//bits per channel
+	header.push_back(6);//RGBA
+	header.push_back(0);//deflate
+	header.push_back(0);//adaptive filters, every row uses none
+	header.push_back(0);//not interlaced
+	writeChunk(file,"IHDR",header);
+
+	//rows with their filter byte
+	const size_t rowBytes = static_cast<size_t>(width)*4;
+	std::vector<uint8_t> raw((rowBytes+1)*height);
+	for(uint32_t y=0;y<height;y++) {
+		const uint32_t source = bottomUp ? height-1-y : y;
+		raw[y*(rowBytes+1)] = 0;
+		std::memcpy(&raw[y*(rowBytes+1)+1],rgba+source*rowBytes,rowBytes);
+	}
+
+	//zlib stream of stored blocks, each at most 65535 bytes
+	std::vector<uint8_t> data;
+	data.reserve(raw.size()+raw.size()/65535*5+16);
+	data.push_back(0x78);
+	data.push_back(0x01);
+	size_t offset = 0;
+	do {
+		const size_t size = std::min<size_t>(raw.size()-offset,65535);
+		const bool last = offset+size==raw.size();
+		data.push_back(last ? 1 : 0);
+		data.push_back(static_cast<uint8_t>(size));
+		data.push_back(static_cast<uint8_t>(size>>8));
+		data.push_back(static_cast<uint8_t>(~size));
+		data.push_back(static_cast<uint8_t>(~size>>8));
+		data.insert(data.end(),raw.begin()+offset,raw.begin()+offset+size);
+		offset += size;
+	}while(offset<raw.size());
+	uint32_t a = 1;
+	uint32_t b = 0;
+	for(size_t i=0;i<raw.size();) {
+		//5552 bytes is the most that can be summed before b overflows
+		const size_t end = std::min(raw.size(),i+5552);
+		for(;i<end;i++) {
+			a += raw[i];
+			b += a;
+		}
+		a %= 65521;
+		b %= 65521;
+	}
+	put32(data,(b<<16)|a);
+	writeChunk(file,"IDAT",data);
+
+	writeChunk(file,"IEND",{});
+	return file.good();
+}
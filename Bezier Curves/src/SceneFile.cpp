@@ -0,0 +1,458 @@
+#include "../include/SceneFile.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+#include <iterator>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+	uint64_t alignUp(const uint64_t offset) {
+		return (offset+SceneFormat::alignment-1)/SceneFormat::alignment*SceneFormat::alignment;
+	}
+}
+
+bool SceneFile::fail(const std::string& message) {
+	Close();
+	error = message;
+	return false;
+}
+
+bool SceneFile::Open(const std::string& path) {
+	Close();
+	error.clear();
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if(file==INVALID_HANDLE_VALUE) {
+		return fail("can't open "+path);
+	}
+	fileHandle = file;
+	LARGE_INTEGER fileSize;
+	if(!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart<static_cast<LONGLONG>(sizeof(SceneFormat::Header))) {
+		return fail(path+" is too small for a scene");
+	}
+	size = static_cast<size_t>(fileSize.QuadPart);
+	mappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if(mappingHandle==nullptr) {
+		return fail("can't map "+path);
+	}
+	data = static_cast<const unsigned char*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+	if(data==nullptr) {
+		return fail("can't map "+path);
+	}
+#else
+	const int file = ::open(path.c_str(), O_RDONLY);
+	if(file<0) {
+		return fail("can't open "+path);
+	}
+	struct stat status;
+	if(fstat(file, &status)!=0 || status.st_size<static_cast<off_t>(sizeof(SceneFormat::Header))) {
+		::close(file);
+		return fail(path+" is too small for a scene");
+	}
+	size = static_cast<size_t>(status.st_size);
+	//scenes are read whole, faulting all pages in at once is cheaper than one fault per page
+#ifdef MAP_POPULATE
+	const int flags = MAP_PRIVATE | MAP_POPULATE;
+#else
+	const int flags = MAP_PRIVATE;
+#endif
+	void* mapping = mmap(nullptr, size, PROT_READ, flags, file, 0);
+	//the mapping keeps the file alive on its own
+	::close(file);
+	if(mapping==MAP_FAILED) {
+		size = 0;
+		return fail("can't map "+path);
+	}
+	data = static_cast<const unsigned char*>(mapping);
+#endif
+	header = reinterpret_cast<const SceneFormat::Header*>(data);
+	if(!validate()) {
+		const std::string message = error;
+		return fail(path+": "+message);
+	}
+	return true;
+}
+
+//only sizes and offsets are checked, the points are whatever floats the file holds
+bool SceneFile::validate() {
+	if(std::memcmp(header->magic, SceneFormat::magic, sizeof(SceneFormat::magic))!=0) {
+		error = "not a scene file";
+		return false;
+	}
+	if(header->byteOrder!=SceneFormat::byteOrderMark) {
+		error = "written on a machine of the other byte order";
+		return false;
+	}
+	if(header->version!=SceneFormat::version || header->headerSize!=sizeof(SceneFormat::Header)) {
+		error = "unsupported version "+std::to_string(header->version);
+		return false;
+	}
+	if(header->fileSize!=size) {
+		error = "truncated or not finished";
+		return false;
+	}
+	if(header->pointsOffset%SceneFormat::alignment!=0 || header->indexOffset%SceneFormat::alignment!=0
+		|| header->pointsOffset>size || header->indexOffset>size
+		|| header->pointCount>(size-header->pointsOffset)/sizeof(glm::vec2)
+		|| header->curveCount>(size-header->indexOffset)/sizeof(SceneFormat::CurveEntry)
+		|| header->pointsOffset+header->pointCount*sizeof(glm::vec2)>header->indexOffset) {
+		error = "sections out of bounds";
+		return false;
+	}
+	points = reinterpret_cast<const glm::vec2*>(data+header->pointsOffset);
+	entries = reinterpret_cast<const SceneFormat::CurveEntry*>(data+header->indexOffset);
+	//one pass over the index, so CurveAt never has to check
+	for(uint64_t i=0;i<header->curveCount;i++) {
+		if(entries[i].firstPoint>header->pointCount || entries[i].pointCount>header->pointCount-entries[i].firstPoint) {
+			error = "curve "+std::to_string(i)+" out of bounds";
+			return false;
+		}
+	}
+	return true;
+}
+
+void SceneFile::Close() {
+#ifdef _WIN32
+	if(data!=nullptr) {
+		UnmapViewOfFile(data);
+	}
+	if(mappingHandle!=nullptr) {
+		CloseHandle(mappingHandle);
+	}
+	if(fileHandle!=nullptr) {
+		CloseHandle(fileHandle);
+	}
+	mappingHandle = nullptr;
+	fileHandle = nullptr;
+#else
+	if(data!=nullptr) {
+		munmap(const_cast<unsigned char*>(data), size);
+	}
+#endif
+	data = nullptr;
+	size = 0;
+	header = nullptr;
+	points = nullptr;
+	entries = nullptr;
+}
+
+bool SceneWriter::Open(const std::string& path) {
+	file.open(path, std::ios::binary | std::ios::trunc);
+	entries.clear();
+	pointCount = 0;
+	curveOpen = false;
+	failed = false;
+	finished = !file.is_open();
+	//the real header is written by Finish, points start right after it
+	const SceneFormat::Header header{};
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	static_assert(sizeof(SceneFormat::Header)%SceneFormat::alignment==0,"the points follow the header directly");
+	return !finished;
+}
+
+void SceneWriter::BeginCurve(const float precision) {
+	if(curveOpen) {
+		EndCurve();
+	}
+	entries.push_back({pointCount,0,precision});
+	curveOpen = true;
+}
+
+void SceneWriter::AddPoints(const glm::vec2* points, const size_t count) {
+	if(finished) {
+		return;
+	}
+	if(!curveOpen) {
+		BeginCurve();
+	}
+	if(count>SceneFormat::maxCurvePoints-entries.back().pointCount) {
+		failed = true;
+		return;
+	}
+	file.write(reinterpret_cast<const char*>(points), static_cast<std::streamsize>(count*sizeof(glm::vec2)));
+	pointCount += count;
+	entries.back().pointCount += static_cast<uint32_t>(count);
+}
+
+void SceneWriter::EndCurve() {
+	curveOpen = false;
+}
+
+bool SceneWriter::Finish() {
+	if(finished) {
+		return false;
+	}
+	finished = true;
+	curveOpen = false;
+	//the zeroed header stays, so the file is rejected instead of read as a scene missing points
+	if(failed) {
+		file.close();
+		return false;
+	}
+	SceneFormat::Header header{};
+	std::memcpy(header.magic, SceneFormat::magic, sizeof(header.magic));
+	header.version = SceneFormat::version;
+	header.byteOrder = SceneFormat::byteOrderMark;
+	header.headerSize = sizeof(SceneFormat::Header);
+	header.curveCount = entries.size();
+	header.pointCount = pointCount;
+	header.pointsOffset = sizeof(SceneFormat::Header);
+	const uint64_t pointsEnd = header.pointsOffset+pointCount*sizeof(glm::vec2);
+	header.indexOffset = alignUp(pointsEnd);
+	header.fileSize = header.indexOffset+entries.size()*sizeof(SceneFormat::CurveEntry);
+	const char padding[SceneFormat::alignment] = {};
+	file.write(padding, static_cast<std::streamsize>(header.indexOffset-pointsEnd));
+	file.write(reinterpret_cast<const char*>(entries.data()), static_cast<std::streamsize>(entries.size()*sizeof(SceneFormat::CurveEntry)));
+	file.seekp(0);
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.close();
+	return !file.fail();
+}
+
+namespace {
+	//path data tokens, numbers may follow each other without separators as in "1.5.5" or "2-3"
+	class PathReader {
+		const char* text;
+		const char* end;
+	public:
+		PathReader(const char* text, const char* end):text(text),end(end) {}
+		void skipSeparators() {
+			while(text<end && (std::isspace(static_cast<unsigned char>(*text)) || *text==',')) {
+				text++;
+			}
+		}
+		bool atEnd() {
+			skipSeparators();
+			return text>=end;
+		}
+		bool atCommand() {
+			skipSeparators();
+			return text<end && std::isalpha(static_cast<unsigned char>(*text)) && *text!='e' && *text!='E';
+		}
+		char command() {
+			return *text++;
+		}
+		bool number(float& value) {
+			skipSeparators();
+			if(text>=end) {
+				return false;
+			}
+			char* numberEnd = nullptr;
+			value = std::strtof(text, &numberEnd);
+			if(numberEnd==text) {
+				return false;
+			}
+			text = numberEnd;
+			return true;
+		}
+		bool point(glm::vec2& p) {
+			return number(p.x) && number(p.y);
+		}
+	};
+
+	size_t importPath(const char* data, const char* end, SceneWriter& writer, const float precision) {
+		PathReader reader(data, end);
+		size_t curves = 0;
+		const auto emit = [&](std::initializer_list<glm::vec2> points) {
+			writer.AddCurve(points.begin(), points.size(), precision);
+			curves++;
+		};
+		glm::vec2 current(0.0f);
+		glm::vec2 start(0.0f);
+		//for the reflected control points of S and T
+		glm::vec2 lastControl(0.0f);
+		char last = 0;
+		char command = 0;
+		while(!reader.atEnd()) {
+			if(reader.atCommand()) {
+				command = reader.command();
+			}else if(command==0) {
+				break;
+			}
+			const bool relative = std::islower(static_cast<unsigned char>(command))!=0;
+			const glm::vec2 origin = relative ? current : glm::vec2(0.0f);
+			const char upper = static_cast<char>(std::toupper(static_cast<unsigned char>(command)));
+			glm::vec2 p, c1, c2;
+			float value;
+			bool ok = true;
+			switch(upper) {
+			case 'M':
+				if((ok = reader.point(p))) {
+					current = start = origin+p;
+					//further pairs are implicit line tos
+					command = relative ? 'l' : 'L';
+				}
+				break;
+			case 'L':
+				if((ok = reader.point(p))) {
+					emit({current, origin+p});
+					current = origin+p;
+				}
+				break;
+			case 'H':
+				if((ok = reader.number(value))) {
+					p = glm::vec2(relative ? current.x+value : value, current.y);
+					emit({current, p});
+					current = p;
+				}
+				break;
+			case 'V':
+				if((ok = reader.number(value))) {
+					p = glm::vec2(current.x, relative ? current.y+value : value);
+					emit({current, p});
+					current = p;
+				}
+				break;
+			case 'C':
+				if((ok = reader.point(c1) && reader.point(c2) && reader.point(p))) {
+					emit({current, origin+c1, origin+c2, origin+p});
+					lastControl = origin+c2;
+					current = origin+p;
+				}
+				break;
+			case 'S':
+				if((ok = reader.point(c2) && reader.point(p))) {
+					c1 = (last=='C' || last=='S') ? current*2.0f-lastControl : current;
+					emit({current, c1, origin+c2, origin+p});
+					lastControl = origin+c2;
+					current = origin+p;
+				}
+				break;
+			case 'Q':
+				if((ok = reader.point(c1) && reader.point(p))) {
+					emit({current, origin+c1, origin+p});
+					lastControl = origin+c1;
+					current = origin+p;
+				}
+				break;
+			case 'T':
+				if((ok = reader.point(p))) {
+					c1 = (last=='Q' || last=='T') ? current*2.0f-lastControl : current;
+					emit({current, c1, origin+p});
+					lastControl = c1;
+					current = origin+p;
+				}
+				break;
+			case 'A': {
+				float arc[5];
+				for(float& a : arc) {
+					ok = ok && reader.number(a);
+				}
+				if((ok = ok && reader.point(p))) {
+					emit({current, origin+p});
+					current = origin+p;
+				}
+				break;
+			}
+			case 'Z':
+				if(current!=start) {
+					emit({current, start});
+				}
+				current = start;
+				command = 0;
+				break;
+			default:
+				ok = false;
+				break;
+			}
+			if(!ok) {//malformed data, the rest of the path is dropped like browsers do
+				break;
+			}
+			last = upper;
+		}
+		return curves;
+	}
+
+	//value of attribute name in the element text, empty when it's missing
+	bool findAttribute(const std::string& element, const char* name, size_t& first, size_t& last) {
+		const size_t nameLength = std::strlen(name);
+		for(size_t at=element.find(name);at!=std::string::npos;at=element.find(name, at+1)) {
+			if(at==0 || !std::isspace(static_cast<unsigned char>(element[at-1]))) {
+				continue;
+			}
+			size_t i = at+nameLength;
+			while(i<element.size() && std::isspace(static_cast<unsigned char>(element[i]))) {
+				i++;
+			}
+			if(i>=element.size() || element[i]!='=') {
+				continue;
+			}
+			i++;
+			while(i<element.size() && std::isspace(static_cast<unsigned char>(element[i]))) {
+				i++;
+			}
+			if(i>=element.size() || (element[i]!='"' && element[i]!='\'')) {
+				continue;
+			}
+			const size_t close = element.find(element[i], i+1);
+			if(close==std::string::npos) {
+				return false;
+			}
+			first = i+1;
+			last = close;
+			return true;
+		}
+		return false;
+	}
+}
+
+size_t SceneImport::Svg(std::istream& in, SceneWriter& writer, const float precision) {
+	const std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+	size_t curves = 0;
+	for(size_t at=text.find("<path");at!=std::string::npos;at=text.find("<path", at+5)) {
+		const size_t close = text.find('>', at);
+		const std::string element = text.substr(at, close==std::string::npos ? std::string::npos : close-at);
+		size_t first = 0;
+		size_t last = 0;
+		if(findAttribute(element, "d", first, last)) {
+			curves += importPath(element.data()+first, element.data()+last, writer, precision);
+		}
+	}
+	return curves;
+}
+
+size_t SceneImport::Text(std::istream& in, SceneWriter& writer, const float precision) {
+	const size_t before = writer.CurveCount();
+	std::string line;
+	bool curveOpen = false;
+	while(std::getline(in, line)) {
+		const char* text = line.c_str();
+		while(std::isspace(static_cast<unsigned char>(*text))) {
+			text++;
+		}
+		if(*text=='\0' || *text=='#') {
+			continue;
+		}
+		if(std::strncmp(text, "curve", 5)==0) {
+			char* end = nullptr;
+			const float p = std::strtof(text+5, &end);
+			writer.BeginCurve(end!=text+5 && p>0.0f ? p : precision);
+			curveOpen = true;
+			continue;
+		}
+		PathReader reader(text, line.c_str()+line.size());
+		glm::vec2 point;
+		if(!reader.point(point)) {
+			continue;
+		}
+		if(!curveOpen) {
+			writer.BeginCurve(precision);
+			curveOpen = true;
+		}
+		writer.AddPoint(point);
+	}
+	writer.EndCurve();
+	return writer.CurveCount()-before;
+}
@@ -1,4 +1,10 @@
 #include "../include/Shader.h"
+#include "../include/GLExt.h"
+
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+#include <iterator>
 
 Shader::Shader(const char* vertexPath, const char* fragmentPath) {
 	// retrieve the vertex/fragment source code from filePath
@@ -31,48 +37,9 @@ Shader::Shader(const char* vertexPath, const char* fragmentPath) {
 	catch (std::exception& e) {
 		std::cout << e.what() << std::endl;
 	}
-	const char* vShaderCode = vertexCode.c_str();
-	const char* fShaderCode = fragmentCode.c_str();
-
-	// compile shaders
-	unsigned int vertex, fragment;
-	int success;
-	char infoLog[512];
-	// vertex shader
-	vertex = glCreateShader(GL_VERTEX_SHADER);
-	glShaderSource(vertex, 1, &vShaderCode, NULL);
-	glCompileShader(vertex);
-	// print compile errors if any
-	glGetShaderiv(vertex, GL_COMPILE_STATUS, &success);
-	if (!success) {
-		glGetShaderInfoLog(vertex, 512, NULL, infoLog);
-		std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
-	}
-	// fragment shader
-	fragment = glCreateShader(GL_FRAGMENT_SHADER);
-	glShaderSource(fragment, 1, &fShaderCode, NULL);
-	glCompileShader(fragment);
-	// print compile errors if any
-	glGetShaderiv(fragment, GL_COMPILE_STATUS, &success);
-	if (!success) {
-		glGetShaderInfoLog(fragment, 512, NULL, infoLog);
-		std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
-	}
-
-	//create shader program
-	id = glCreateProgram();
-	glAttachShader(id, vertex);
-	glAttachShader(id, fragment);
-	glLinkProgram(id);
-	// print linking errors if any
-	glGetProgramiv(id, GL_LINK_STATUS, &success);
-	if (!success) {
-		glGetProgramInfoLog(id, 512, NULL, infoLog);
-		std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
-	}
-	// delete shaders; theyre linked into our program and no longer necessary
-	glDeleteShader(vertex);
-	glDeleteShader(fragment);
+	const GLenum types[] = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER };
+	const std::string sources[] = { vertexCode, fragmentCode };
+	build(types, sources, 2);
 }
 Shader::Shader(const char* vertexPath, const char* geometryPath, const char* fragmentPath) {
 	// retrieve the vertex/fragment source code from filePath
@@ -111,50 +78,78 @@ Shader::Shader(const char* vertexPath, const char* geometryPath, const char* fra
 	} catch (std::exception& e) {
 		std::cout << e.what() << std::endl;
 	}
-	const char* vShaderCode = vertexCode.c_str();
-	const char* gShaderCode = geometryCode.c_str();
-	const char* fShaderCode = fragmentCode.c_str();
+	const GLenum types[] = { GL_VERTEX_SHADER, GL_GEOMETRY_SHADER, GL_FRAGMENT_SHADER };
+	const std::string sources[] = { vertexCode, geometryCode, fragmentCode };
+	build(types, sources, 3);
+}
+
+namespace {
+	const char* stageName(GLenum type) {
+		switch (type) {
+		case GL_VERTEX_SHADER: return "VERTEX";
+		case GL_GEOMETRY_SHADER: return "GEOMETRY";
+		default: return "FRAGMENT";
+		}
+	}
+
+	// FNV-1a, only has to tell different sources and drivers apart
+	void hashString(uint64_t& hash, const std::string& text) {
+		for (const char c : text) {
+			hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+		}
+		hash = (hash ^ 0xff) * 1099511628211ull;// separator, "ab"+"c" and "a"+"bc" differ
+	}
+
+	std::string glString(GLenum name) {
+		const GLubyte* text = glGetString(name);
+		return text != nullptr ? reinterpret_cast<const char*>(text) : "";
+	}
+}
+
+std::string Shader::binaryCacheDirectory = "shader_cache";
+
+void Shader::build(const GLenum* types, const std::string* sources, int count) {
+	id = glCreateProgram();
+	// a binary only matches the exact sources on the exact driver that produced it
+	std::string cachePath;
+	if (!binaryCacheDirectory.empty() && GLExt::hasProgramBinary()) {
+		uint64_t hash = 14695981039346656037ull;
+		for (int i = 0; i < count; i++) {
+			hashString(hash, sources[i]);
+		}
+		hashString(hash, glString(GL_VENDOR));
+		hashString(hash, glString(GL_RENDERER));
+		hashString(hash, glString(GL_VERSION));
+		std::ostringstream name;
+		name << binaryCacheDirectory << "/" << std::hex << hash << ".bin";
+		cachePath = name.str();
+		if (loadBinary(cachePath)) {
+			cacheUniforms();
+			return;
+		}
+		GLExt::programParameteri(id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
 
 	// compile shaders
-	unsigned int vertex, geometry, fragment;
 	int success;
 	char infoLog[512];
-	// vertex shader
-	vertex = glCreateShader(GL_VERTEX_SHADER);
-	glShaderSource(vertex, 1, &vShaderCode, NULL);
-	glCompileShader(vertex);
-	// print compile errors if any
-	glGetShaderiv(vertex, GL_COMPILE_STATUS, &success);
-	if (!success) {
-		glGetShaderInfoLog(vertex, 512, NULL, infoLog);
-		std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
-	}
-	// geometry shader
-	geometry = glCreateShader(GL_GEOMETRY_SHADER);
-	glShaderSource(geometry, 1, &gShaderCode, NULL);
-	glCompileShader(geometry);
-	// print compile errors if any
-	glGetShaderiv(geometry, GL_COMPILE_STATUS, &success);
-	if (!success) {
-		glGetShaderInfoLog(geometry, 512, NULL, infoLog);
-		std::cout << "ERROR::SHADER::GEOMETRY::COMPILATION_FAILED\n" << infoLog << std::endl;
-	}
-	// fragment shader
-	fragment = glCreateShader(GL_FRAGMENT_SHADER);
-	glShaderSource(fragment, 1, &fShaderCode, NULL);
-	glCompileShader(fragment);
-	// print compile errors if any
-	glGetShaderiv(fragment, GL_COMPILE_STATUS, &success);
-	if (!success) {
-		glGetShaderInfoLog(fragment, 512, NULL, infoLog);
-		std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
+	std::vector<GLuint> shaders;
+	for (int i = 0; i < count; i++) {
+		const char* code = sources[i].c_str();
+		const GLuint shader = glCreateShader(types[i]);
+		glShaderSource(shader, 1, &code, NULL);
+		glCompileShader(shader);
+		// print compile errors if any
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+		if (!success) {
+			glGetShaderInfoLog(shader, 512, NULL, infoLog);
+			std::cout << "ERROR::SHADER::" << stageName(types[i]) << "::COMPILATION_FAILED\n" << infoLog << std::endl;
+		}
+		glAttachShader(id, shader);
+		shaders.push_back(shader);
 	}
 
-	//create shader program
-	id = glCreateProgram();
-	glAttachShader(id, vertex);
-	glAttachShader(id, geometry);
-	glAttachShader(id, fragment);
+	//link shader program
 	glLinkProgram(id);
 	// print linking errors if any
 	glGetProgramiv(id, GL_LINK_STATUS, &success);
@@ -163,15 +158,84 @@ Shader::Shader(const char* vertexPath, const char* geometryPath, const char* fra
 		std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
 	}
 	// delete shaders; theyre linked into our program and no longer necessary
-	glDeleteShader(vertex);
-	glDeleteShader(geometry);
-	glDeleteShader(fragment);
+	for (const GLuint shader : shaders) {
+		glDeleteShader(shader);
+	}
+	if (success && !cachePath.empty()) {
+		saveBinary(cachePath);
+	}
+	cacheUniforms();
+}
+
+// the file is the binary format followed by the binary
+bool Shader::loadBinary(const std::string& path) {
+	std::ifstream file(path, std::ios::binary);
+	GLenum format = 0;
+	if (!file.read(reinterpret_cast<char*>(&format), sizeof(format))) {
+		return false;
+	}
+	const std::vector<char> binary((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	if (binary.empty()) {
+		return false;
+	}
+	GLExt::programBinary(id, format, binary.data(), static_cast<GLsizei>(binary.size()));
+	// a driver update can reject an old binary even with the same version string, then it's compiled again
+	int success;
+	glGetProgramiv(id, GL_LINK_STATUS, &success);
+	return success != 0;
+}
+
+void Shader::saveBinary(const std::string& path) const {
+	GLint length = 0;
+	glGetProgramiv(id, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0) {
+		return;
+	}
+	std::vector<char> binary(length);
+	GLenum format = 0;
+	GLExt::getProgramBinary(id, length, &length, &format, binary.data());
+	std::error_code error;
+	std::filesystem::create_directories(binaryCacheDirectory, error);
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	file.write(reinterpret_cast<const char*>(&format), sizeof(format));
+	file.write(binary.data(), length);
+	if (!file) {
+		std::cout << "ERROR::SHADER::BINARY_CACHE_NOT_WRITTEN: " << path << std::endl;
+	}
+}
+
+void Shader::cacheUniforms() {
+	uniformLocations.clear();
+	GLint count = 0;
+	GLint maxLength = 0;
+	glGetProgramiv(id, GL_ACTIVE_UNIFORMS, &count);
+	glGetProgramiv(id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+	std::vector<GLchar> name(std::max(maxLength, 1));
+	for (GLint i = 0; i < count; i++) {
+		GLsizei length = 0;
+		GLint size = 0;
+		GLenum type = 0;
+		glGetActiveUniform(id, i, static_cast<GLsizei>(name.size()), &length, &size, &type, name.data());
+		std::string uniform(name.data(), length);
+		if (uniform.size() > 3 && uniform.compare(uniform.size() - 3, 3, "[0]") == 0) {// arrays are reported as name[0]
+			uniform.resize(uniform.size() - 3);
+		}
+		const GLint location = glGetUniformLocation(id, uniform.c_str());
+		if (location >= 0) {// uniform block members have no location
+			uniformLocations[uniform] = location;
+		}
+	}
 }
 
 void Shader::use() const {
 	glUseProgram(id);
 }
 
+GLint Shader::getUniformLocation(const std::string& name) const {
+	const auto it = uniformLocations.find(name);
+	return it != uniformLocations.end() ? it->second : -1;
+}
+
 GLuint Shader::getUniformIndex(const std::string& name) const {
 	return glGetUniformBlockIndex(id, name.c_str());
 }
@@ -181,44 +245,81 @@ void Shader::bindUniformBlock(GLuint index, GLuint bindingPoint) const{
 }
 
 void Shader::setBool(const std::string& name, bool value) const {
-	glUniform1i(glGetUniformLocation(id, name.c_str()), /*static_cast<int>(value)*/value);
+	glUniform1i(getUniformLocation(name), /*static_cast<int>(value)*/value);
 }
 
 void Shader::setInt(const std::string& name, int value) const {
-	glUniform1i(glGetUniformLocation(id, name.c_str()), value);
+	glUniform1i(getUniformLocation(name), value);
 }
 
 void Shader::setFloat(const std::string& name, float value) const {
-	glUniform1f(glGetUniformLocation(id, name.c_str()), value);
+	glUniform1f(getUniformLocation(name), value);
 }
 
 void Shader::setVec2(const std::string& name, glm::vec2& value) const {
-	glUniform2fv(glGetUniformLocation(id, name.c_str()), 1, &value[0]);
+	glUniform2fv(getUniformLocation(name), 1, &value[0]);
 }
 void Shader::setVec2(const std::string& name, float x, float y) const {
-	glUniform2f(glGetUniformLocation(id, name.c_str()), x, y);
+	glUniform2f(getUniformLocation(name), x, y);
 }
 
 void Shader::setVec3(const std::string& name, const glm::vec3& value) const {
-	glUniform3fv(glGetUniformLocation(id, name.c_str()), 1, &value[0]);
+	glUniform3fv(getUniformLocation(name), 1, &value[0]);
 }
 void Shader::setVec3(const std::string& name, float x, float y, float z) const {
-	glUniform3f(glGetUniformLocation(id, name.c_str()), x, y, z);
+	glUniform3f(getUniformLocation(name), x, y, z);
 }
 
 void Shader::setVec4(const std::string& name, const glm::vec4& value) const {
-	glUniform4fv(glGetUniformLocation(id, name.c_str()), 1, &value[0]);
+	glUniform4fv(getUniformLocation(name), 1, &value[0]);
 }
 void Shader::setVec4(const std::string& name, float x, float y, float z, float w) const {
-	glUniform4f(glGetUniformLocation(id, name.c_str()), x, y, z, w);
+	glUniform4f(getUniformLocation(name), x, y, z, w);
 }
 
 void Shader::setMat2(const std::string& name, const glm::mat2& mat) const {
-	glUniformMatrix2fv(glGetUniformLocation(id, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+	glUniformMatrix2fv(getUniformLocation(name), 1, GL_FALSE, &mat[0][0]);
 }
 void Shader::setMat3(const std::string& name, const glm::mat3& mat) const {
-	glUniformMatrix3fv(glGetUniformLocation(id, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+	glUniformMatrix3fv(getUniformLocation(name), 1, GL_FALSE, &mat[0][0]);
 }
 void Shader::setMat4(const std::string& name, const glm::mat4& mat) const {
-	glUniformMatrix4fv(glGetUniformLocation(id, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+	glUniformMatrix4fv(getUniformLocation(name), 1, GL_FALSE, &mat[0][0]);
+}
+
+void Shader::setBool(GLint location, bool value) const {
+	glUniform1i(location, value);
+}
+
+void Shader::setInt(GLint location, int value) const {
+	glUniform1i(location, value);
+}
+
+void Shader::setFloat(GLint location, float value) const {
+	glUniform1f(location, value);
+}
+
+void Shader::setVec2(GLint location, const glm::vec2& value) const {
+	glUniform2fv(location, 1, &value[0]);
+}
+void Shader::setVec2(GLint location, float x, float y) const {
+	glUniform2f(location, x, y);
+}
+
+void Shader::setVec3(GLint location, const glm::vec3& value) const {
+	glUniform3fv(location, 1, &value[0]);
+}
+
+void Shader::setVec4(GLint location, const glm::vec4& value) const {
+	glUniform4fv(location, 1, &value[0]);
+}
+
+void Shader::setMat2(GLint location, const glm::mat2& mat) const {
+	glUniformMatrix2fv(location, 1, GL_FALSE, &mat[0][0]);
+}
+void Shader::setMat3(GLint location, const glm::mat3& mat) const {
+	glUniformMatrix3fv(location, 1, GL_FALSE, &mat[0][0]);
 }
+void Shader::setMat4(GLint location, const glm::mat4& mat) const {
+	glUniformMatrix4fv(location, 1, GL_FALSE, &mat[0][0]);
+}
\ No newline at end of file
@@ -7,14 +7,39 @@
 
 #include <iostream>
 #include <vector>
+#include <array>
 #include <functional>
+#include <memory_resource>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstdlib>
+#include <new>
+#include <chrono>
+#include <cmath>
+#include <string>
 
 #include "../include/VBO.h"
 #include "../include/VAO.h"
+#include "../include/StreamVBO.h"
+#include "../include/FrameBuffer.h"
 #include "../include/Shader.h"
 #include "../include/Time.h"
+#include "../include/Redraw.h"
+#include "../include/Profiler.h"
+#include "../include/GpuTimer.h"
+#include "../include/CountingResource.h"
 
 #include "../include/BezierCurve.h"
+#include "../include/CurveScene.h"
+#include "../include/ThreadPool.h"
+#include "../include/SpatialGrid.h"
+#include "../include/BoundingBox.h"
+#include "../include/SceneFile.h"
+#include "../include/TessellationThread.h"
+#include "../include/EditScript.h"
+#include "../include/PngWriter.h"
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void processInput(GLFWwindow* window);
@@ -22,16 +47,56 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 void mouse_cursor_callback(GLFWwindow* window, double xpos, double ypos);
 void mouse_scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
+void window_refresh_callback(GLFWwindow* window);
 std::function<void()> shader_viewpoint_callback;
 
+#if BEZIER_PROFILE
+//every plain allocation of the process shows up in the frame's allocation counter
+void* operator new(const size_t size) {
+    Profiler::CountAllocation(size);
+    if(void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+#endif
+GpuTimer gpuTimer;
+
 float SCR_WIDTH = 800;
 float SCR_HEIGHT = 600;
 
+//world position of the top left corner and pixels per world unit
+glm::vec2 viewOffset(0.0f);
+float viewZoom = 1.0f;
+glm::mat4 projection = glm::ortho(0.0f,SCR_WIDTH,SCR_HEIGHT,0.0f);
+
+glm::vec2 screenToWorld(const glm::vec2 pos) {
+    return viewOffset+pos/viewZoom;
+}
+BoundingBox viewBox() {
+    return {viewOffset,screenToWorld({SCR_WIDTH,SCR_HEIGHT})};
+}
+void updateProjection() {
+    const BoundingBox view = viewBox();
+    projection = glm::ortho(view.min.x,view.max.x,view.max.y,view.min.y);
+    shader_viewpoint_callback();
+    Redraw::Request();
+}
+
 class Mouse {
 public:
     Mouse(const float x,const float y):pos({x,y}){}
     Mouse():Mouse(0,0){}
     glm::vec2 pos;
+    glm::vec2 WorldPos() const {
+        return screenToWorld(pos);
+    }
     bool leftPressed = false;
     bool rightPressed = false;
     bool wheelScrolled = false;
@@ -40,93 +105,969 @@ public:
 Mouse mouse(SCR_WIDTH/2.0f,SCR_HEIGHT/2.0f);
 
 class BezierCurveVisualizer {
-	GLuint bc_vbo = 0;
+	StreamVBO bc_stream;
 	GLuint bc_vao = 0;
 	GLuint points_vbo = 0;
 	GLuint points_vao = 0;
+	//texture buffer view of points_vbo, the gpu tessellated lines are instances with a curve each from gpu_vbo
+	GLuint points_tbo = 0;
+	GLuint gpu_vbo = 0;
+	GLuint gpu_vao = 0;
+	struct GpuCurve {
+		GLint firstPoint;
+		GLint pointCount;
+		GLint samples;
+	};
+	//strokes read the line vertices through lines_tbo, a view of the whole stream, and get one instance per line from stroke_vbo
+	GLuint lines_tbo = 0;
+	GLuint stroke_vbo = 0;
+	GLuint stroke_vao = 0;
+	struct StrokeLine {
+		GLint first;
+		GLint count;
+	};
+	//rebuilt every frame from the visible curves, drawn with one call per primitive type and instance bucket
+	std::vector<GLint> lineFirsts;
+	std::vector<GLsizei> lineCounts;
+	std::vector<StrokeLine> strokeLines;
+	std::vector<StrokeLine> sortedStrokeLines;
+	std::vector<GpuCurve> gpuCurves;
+	std::vector<GpuCurve> sortedGpuCurves;
+	//every instance of a draw call runs as many vertices as the longest one needs, so instances are sorted into buckets
+	//of up to 2^b segments and each bucket is its own call, which keeps the vertex work below twice the segments drawn
+	struct InstanceBucket {
+		GLint first;
+		GLsizei count;
+		GLint segments;
+	};
+	std::vector<InstanceBucket> instanceBuckets;
+	template<class Instance, class Segments>
+	void bucketInstances(const std::vector<Instance>& instances, std::vector<Instance>& sorted, const Segments segments) {
+		std::array<GLint,33> offsets{};
+		const auto bucketOf = [](const GLint count) {
+			int b = 0;
+			while((GLint(1)<<b)<count) {
+				b++;
+			}
+			return b;
+		};
+		for(const Instance& instance : instances) {
+			if(segments(instance)>0) {
+				offsets[bucketOf(segments(instance))+1]++;
+			}
+		}
+		instanceBuckets.clear();
+		for(int b=0;b<32;b++) {
+			if(offsets[b+1]>0) {
+				instanceBuckets.push_back({offsets[b],offsets[b+1],GLint(1)<<b});
+			}
+			offsets[b+1] += offsets[b];
+		}
+		sorted.resize(offsets[32]);
+		for(const Instance& instance : instances) {
+			if(segments(instance)>0) {
+				sorted[offsets[bucketOf(segments(instance))]++] = instance;
+			}
+		}
+	}
+    //the shader's first weight is s^n with s>=0.5, which is a normal float down to 2^-126, so n is at most 126
+    //gpus that flush denormals would lose the whole curve around t=0.5 above that, longer curves keep cpu lines
+    const size_t maxGpuPoints = 127;
+    const float pointSize = 5.0f;
+    //strokes are quads with analytic coverage, hairlines plain GL_LINE_STRIPs without smoothing
+    bool strokes = true;
+    float strokeWidth = 2.0f;
+    const float minStrokeWidth = 1.0f;
+    const float maxStrokeWidth = 32.0f;
+    bool gpuTessellation = false;
+    //per frame uniforms, resolved once by ResolveUniforms after the shaders are built
+    GLint pointSizeUniform = -1;
+    GLint strokeWidthUniform = -1;
+    GLint gpuStrokeWidthUniform = -1;
 	const float pointCaptureDistance = 10.0f;
-    glm::vec2* capturedPoint = nullptr;
-    int capturedPointIndex = 0;
+    //a handle instead of a pointer, adding points may move the storage
+    BezierCurve::PointHandle capturedPoint;
+    bool pointCaptured = false;
+    int capturedCurve = 0;
+    bool capturedPointMoved = false;
+    //curve double clicks add points to
+    int activeCurve = 0;
+    ThreadPool tessellationPool;
+    //in async mode edits are queued for the thread and frames draw its newest tessellation, otherwise Update tessellates and waits
+    //the thread uses tessellationPool, which is why it is stopped before Update does again
+    TessellationThread tessellator{tessellationPool,Redraw::RequestFromThread};
+    bool asyncTessellation = true;
+    //curves whose last edit didn't fit into the queue, Update sends them again
+    std::vector<uint8_t> unsent;
+    bool viewSent = false;
+    BoundingBox sentView;
+    float sentZoom = 1.0f;
+    size_t sentMinLinePoints = 0;
+    //revisions of the frame arrays in the buffers, a frame that only culled again uploads nothing
+    uint64_t uploadedPoints = 0;
+    uint64_t uploadedVertices = 0;
+    //every buffer upload since the last TakeUploadedBytes
+    size_t uploadedBytes = 0;
+    void countUpload(const size_t bytes) {
+        PROFILE_COUNT("uploaded bytes",bytes);
+        uploadedBytes += bytes;
+    }
+    //workers grow curve scratch buffers too, so the pool has to be synchronized
+    //the pool takes its blocks through curveUpstream, which counts them for the profiler
+    CountingResource curveUpstream;
+    std::pmr::synchronized_pool_resource curveMemory{&curveUpstream};
+    //control points for picking, kept in sync with every add, drag and erase
+    struct PickPoint {
+        size_t curve;
+        BezierCurve::PointHandle handle;
+        glm::vec2 pos;
+        bool operator==(const PickPoint& other) const {
+            return curve==other.curve && handle.slot==other.handle.slot && handle.generation==other.handle.generation;
+        }
+    };
+    SpatialGrid<PickPoint> pointGrid{pointCaptureDistance};
+    //lines are only brought up to date when a click needs them, not while dragging
+    LineGrid lineGrid{pointCaptureDistance};
+    std::vector<uint32_t> lineGridRevisions;
+    void addPickPoint(const size_t curve, const BezierCurve::PointHandle handle) {
+        const glm::vec2 pos = scene.curves[curve].Points()[scene.curves[curve].IndexOf(handle)];
+        pointGrid.Insert({curve,handle,pos},pos,pos);
+    }
+    //the edits of the mouse and of scripts, picking is kept in sync with them
+    void movePoint(const size_t curve, const size_t index, const glm::vec2 pos) {
+        const glm::vec2 oldPos = scene.curves[curve].Points()[index];
+        if(asyncTessellation) {
+            scene.curves[curve].SetPoint(index,pos);
+            submitMove(curve,index,pos);
+        }else {
+            upload(scene.MovePoint(curve,index,pos));
+        }
+        pointGrid.Move({curve,scene.curves[curve].HandleAt(index),pos},oldPos,pos);
+        Redraw::Request();
+    }
+    BezierCurve::PointHandle addPoint(const size_t curve, const glm::vec2 pos) {
+        const BezierCurve::PointHandle handle = scene.curves[curve].AddPoint(pos);
+        addPickPoint(curve,handle);
+        UpdateCurve(curve);
+        return handle;
+    }
+    //cells of the smallest power of two times pointCaptureDistance that holds the pick radius in world units, so a pick visits
+    //at most 3x3 cells at any zoom and zooming only rebuilds the grids when the radius leaves that factor of two
+    //zoomed in they stay at pointCaptureDistance, smaller cells wouldn't visit fewer and would split long segments into more pieces
+    void fitPickGrids(const float radius) {
+        const float cellSize = pointCaptureDistance*std::exp2(std::max(0.0f,std::ceil(std::log2(radius/pointCaptureDistance))));
+        if(cellSize==pointGrid.CellSize()) {
+            return;
+        }
+        pointGrid.Reset(cellSize);
+        for(size_t c=0;c<scene.curves.size();c++) {
+            for(size_t i=0;i<scene.curves[c].Points().size();i++) {
+                addPickPoint(c,scene.curves[c].HandleAt(i));
+            }
+        }
+        lineGrid.Reset(cellSize);
+        lineGridRevisions.clear();
+    }
+    void updateLineGrid() {
+        const TessellationThread::Frame* frame = asyncFrame();
+        if(asyncTessellation && !frame) {
+            return;
+        }
+        const size_t curves = frame ? frame->lineSlices.size() : scene.curves.size();
+        const glm::vec2* vertices = frame ? frame->vertices.data() : scene.Vertices().data();
+        lineGridRevisions.resize(curves,UINT32_MAX);
+        for(size_t i=0;i<curves;i++) {
+            const uint32_t revision = frame ? frame->lineRevisions[i] : scene.LineRevision(i);
+            if(lineGridRevisions[i]!=revision) {
+                const CurveScene::Slice& line = frame ? frame->lineSlices[i] : scene.LineSlice(i);
+                lineGrid.SetLine(i,vertices+line.first,line.count);
+                lineGridRevisions[i] = revision;
+            }
+        }
+    }
+    //the frame being drawn in async mode, nullptr in sync mode and before the thread's first frame
+    const TessellationThread::Frame* asyncFrame() const {
+        return asyncTessellation ? tessellator.Current() : nullptr;
+    }
+    //marks the curve for the next retry when the queue is full
+    void submit(const size_t curve) {
+        if(unsent.size()<scene.curves.size()) {
+            unsent.resize(scene.curves.size(),0);
+        }
+        unsent[curve] = !tessellator.SubmitCurve(curve,scene.curves[curve]);
+    }
+    //the thread moves the point incrementally, a curve still waiting for its snapshot gets the move with it
+    void submitMove(const size_t curve, const size_t index, const glm::vec2 pos) {
+        if(unsent.size()<scene.curves.size()) {
+            unsent.resize(scene.curves.size(),0);
+        }
+        if(unsent[curve] || !tessellator.SubmitMovePoint(curve,index,pos)) {
+            unsent[curve] = 1;
+        }
+    }
+    //everything the thread doesn't have yet, then the newest frame it finished
+    void updateAsync() {
+        {
+            PROFILE_SCOPE("submit");
+            for(size_t i=0;i<unsent.size();i++) {
+                if(unsent[i]) {
+                    submit(i);
+                }
+            }
+            const BoundingBox view = viewBox();
+            if(!viewSent || view.min!=sentView.min || view.max!=sentView.max || viewZoom!=sentZoom) {
+                viewSent = tessellator.SubmitView(view,viewZoom);
+                sentView = view;
+                sentZoom = viewZoom;
+            }
+            if(sentMinLinePoints!=scene.GetMinLinePoints() && tessellator.SubmitMinLinePoints(scene.GetMinLinePoints())) {
+                sentMinLinePoints = scene.GetMinLinePoints();
+            }
+        }
+        if(tessellator.Acquire()) {
+            PROFILE_SCOPE("upload");
+            const TessellationThread::Frame& frame = *tessellator.Current();
+            if(frame.pointRevision!=uploadedPoints) {
+                VBO::setData(points_vbo,sizeof(glm::vec2)*frame.controlPoints.size(),frame.controlPoints.data(),GL_STATIC_DRAW);
+                countUpload(sizeof(glm::vec2)*frame.controlPoints.size());
+                uploadedPoints = frame.pointRevision;
+            }
+            if(frame.vertexRevision!=uploadedVertices) {
+                CurveScene::Slice changed;
+                if(frame.ChangesSince(uploadedVertices,changed)) {
+                    bc_stream.invalidate(sizeof(glm::vec2)*changed.first,sizeof(glm::vec2)*changed.count);
+                }else {
+                    bc_stream.invalidateAll();
+                }
+                streamVertices(frame.vertices.data(),frame.vertices.size());
+                uploadedVertices = frame.vertexRevision;
+            }
+        }
+    }
+    void startAsync() {
+        tessellator.Start();
+        unsent.assign(scene.curves.size(),1);
+        viewSent = false;
+        sentMinLinePoints = SIZE_MAX;
+        uploadedPoints = 0;
+        uploadedVertices = 0;
+        Redraw::Request();
+    }
+    //lines go to the stream once per frame, however many updates there were
+    bool linesChanged = false;
+    //points_vbo holds the points of another scene, the thread's
+    bool pointsStale = false;
+    void upload(const CurveScene::Update& update) {
+        const std::pmr::vector<glm::vec2>& controlPoints = scene.ControlPoints();
+        linesChanged = linesChanged || update.resized || update.lines.count>0;
+        if(update.resized) {
+            bc_stream.invalidateAll();
+        }else {
+            bc_stream.invalidate(sizeof(glm::vec2)*update.lines.first,sizeof(glm::vec2)*update.lines.count);
+        }
+        if(update.resized || pointsStale) {
+            pointsStale = false;
+            VBO::setData(points_vbo,sizeof(glm::vec2)*controlPoints.size(),controlPoints.data(),GL_STATIC_DRAW);
+            countUpload(sizeof(glm::vec2)*controlPoints.size());
+            return;
+        }
+        if(update.points.count>0) {
+            VBO::setSubData(points_vbo,sizeof(glm::vec2)*update.points.first,sizeof(glm::vec2)*update.points.count,controlPoints.data()+update.points.first);
+            countUpload(sizeof(glm::vec2)*update.points.count);
+        }
+    }
+    //the next stream region gets what changed since it was written, the ones before may still be in use by the gpu
+    void streamLines() {
+        if(!linesChanged) {
+            return;
+        }
+        linesChanged = false;
+        streamVertices(scene.Vertices().data(),scene.Vertices().size());
+    }
+    //what was invalidated in bc_stream before has to be all that changed
+    void streamVertices(const glm::vec2* vertices, const size_t count) {
+        const GLuint oldId = bc_stream.id;
+        countUpload(bc_stream.write(vertices,sizeof(glm::vec2)*count));
+        if(bc_stream.id!=oldId) {
+            VBO::bind(bc_stream.id);
+            VAO::addAttrib(bc_vao,0,2,GL_FLOAT,GL_FALSE,2 * sizeof(float),(void*)0);
+            glBindTexture(GL_TEXTURE_BUFFER,lines_tbo);
+            glTexBuffer(GL_TEXTURE_BUFFER,GL_RG32F,bc_stream.id);
+        }
+    }
 public:
-	BezierCurve bezierCurve;
-	void Init() {
-        bezierCurve.points.push_back({100,450});
-        bezierCurve.points.push_back({150,480});
-        bezierCurve.points.push_back({210,450});
-        bezierCurve.points.push_back({040,200});
-        bezierCurve.points.push_back({340,490});
-        bezierCurve.RecalculateLine();
-
-        VBO::generate(bc_vbo,sizeof(glm::vec2)*bezierCurve.linePoints.size(),bezierCurve.linePoints.data(),GL_STATIC_DRAW);
-        VBO::bind(bc_vbo);
+	CurveScene scene{&curveMemory};
+    //the file's points are copied once into the curves, which own them from then on
+    bool LoadScene(const std::string& path) {
+        const SceneFile file(path);
+        if(!file.IsOpen() || file.CurveCount()==0) {
+            std::cout << "Scene not loaded: " << (file.IsOpen() ? path+" has no curves" : file.Error()) << std::endl;
+            return false;
+        }
+        scene.curves.reserve(scene.curves.size()+file.CurveCount());
+        for(size_t i=0;i<file.CurveCount();i++) {
+            const SceneFile::Curve source = file.CurveAt(i);
+            const size_t c = scene.AddCurve();
+            BezierCurve& curve = scene.curves[c];
+            curve.SetPrecision(source.precision);
+            curve.AddPoints(source.points,source.count);
+            for(size_t j=0;j<source.count;j++) {
+                addPickPoint(c,curve.HandleAt(j));
+            }
+        }
+        std::cout << "Loaded " << path << ": " << file.CurveCount() << " curves, " << file.PointCount() << " control points" << std::endl;
+        return true;
+    }
+    void SaveScene(const std::string& path) {
+        SceneWriter writer(path);
+        for(const BezierCurve& curve : scene.curves) {
+            writer.AddCurve(curve.Points().data(),curve.Points().size(),curve.GetPrecision());
+        }
+        if(writer.Finish()) {
+            std::cout << "Wrote " << path << " (" << scene.curves.size() << " curves)" << std::endl;
+        }else {
+            std::cout << "Scene not written: " << path << std::endl;
+        }
+    }
+	void Init(const std::string& scenePath) {
+        if(scenePath.empty() || !LoadScene(scenePath)) {
+            BezierCurve& bezierCurve = scene.curves[scene.AddCurve()];
+            bezierCurve.AddPoint({100,450});
+            bezierCurve.AddPoint({150,480});
+            bezierCurve.AddPoint({210,450});
+            bezierCurve.AddPoint({040,200});
+            bezierCurve.AddPoint({340,490});
+            for(size_t i=0;i<bezierCurve.Points().size();i++) {
+                addPickPoint(0,bezierCurve.HandleAt(i));
+            }
+        }
+        std::cout << "Batch evaluator: " << BezierBatch::Name(BezierBatch::Active()) << ", tessellation threads: " << tessellationPool.ThreadCount() << std::endl;
+
+        bc_stream.create(64*1024);
+        std::cout << "Line stream: " << (bc_stream.isPersistent() ? "persistent mapping" : "unsynchronized map range") << ", "
+                  << StreamVBO::regionCount << " regions" << std::endl;
+        VBO::bind(bc_stream.id);
         VAO::generate(bc_vao);
         VAO::bind(bc_vao);
         VAO::addAttrib(bc_vao,0,2,GL_FLOAT,GL_FALSE,2 * sizeof(float),(void*)0);
+        glGenTextures(1,&lines_tbo);
+        glBindTexture(GL_TEXTURE_BUFFER,lines_tbo);
+        glTexBuffer(GL_TEXTURE_BUFFER,GL_RG32F,bc_stream.id);
+        VBO::generate(stroke_vbo);
+        VBO::bind(stroke_vbo);
+        VAO::generate(stroke_vao);
+        VAO::addIntAttrib(stroke_vao,0,2,GL_INT,sizeof(StrokeLine),(void*)0);
+        VAO::setAttribDivisor(stroke_vao,0,1);
 
-        VBO::generate(points_vbo,sizeof(glm::vec2)*bezierCurve.points.size(),bezierCurve.points.data(),GL_STATIC_DRAW);
+        VBO::generate(points_vbo);
         VBO::bind(points_vbo);
         VAO::generate(points_vao);
         VAO::bind(points_vao);
         VAO::addAttrib(points_vao,0,2,GL_FLOAT,GL_FALSE,2 * sizeof(float),(void*)0);
+        VAO::setAttribDivisor(points_vao,0,1);//a marker per point
+
+        glGenTextures(1,&points_tbo);
+        glBindTexture(GL_TEXTURE_BUFFER,points_tbo);
+        glTexBuffer(GL_TEXTURE_BUFFER,GL_RG32F,points_vbo);
+        VBO::generate(gpu_vbo);
+        VBO::bind(gpu_vbo);
+        VAO::generate(gpu_vao);
+        VAO::addIntAttrib(gpu_vao,0,3,GL_INT,sizeof(GpuCurve),(void*)0);
+        VAO::setAttribDivisor(gpu_vao,0,1);
+
+        if(asyncTessellation) {
+            startAsync();
+        }
+        Update();
+    }
+    void UpdateCurve(const int curve) {
+        scene.MarkDirty(curve);
+        if(asyncTessellation) {
+            submit(curve);
+        }
+        Redraw::Request();
+    }
+    void UpdateAll() {
+        scene.MarkAllDirty();
+        if(asyncTessellation) {
+            for(size_t i=0;i<scene.curves.size();i++) {
+                submit(i);
+            }
+        }
+        Redraw::Request();
+    }
+    //re-tessellates every dirty curve in view on the pool, waits for all of them, uploads the changes and culls for Draw
+    //in async mode it only passes the edits on and takes what the thread finished, it never waits
+    void Update() {
+        PROFILE_SCOPE("update");
+        if(asyncTessellation) {
+            updateAsync();
+            return;
+        }
+        scene.SetView(viewBox(),viewZoom);
+        CurveScene::Update update;
+        {
+            PROFILE_SCOPE("tessellate");
+            scene.BeginTessellation(tessellationPool);
+            update = scene.FinishTessellation(tessellationPool);
+        }
+        {
+            PROFILE_SCOPE("upload");
+            upload(update);
+            streamLines();
+        }
+        {
+            PROFILE_SCOPE("cull");
+            scene.Cull();
+        }
+        PROFILE_COUNT("curve memory blocks",curveUpstream.Allocations());
+        curveUpstream.Reset();
     }
-    void UpdateCurve() {
-        bezierCurve.RecalculateLine();
-        VBO::setData(bc_vbo,sizeof(glm::vec2)*bezierCurve.linePoints.size(),bezierCurve.linePoints.data(),GL_STATIC_DRAW);
-        VBO::setData(points_vbo,sizeof(glm::vec2)*bezierCurve.points.size(),bezierCurve.points.data(),GL_STATIC_DRAW);
+    void ResolveUniforms(const Shader& strokeShader,const Shader& gpuStrokeShader,const Shader& pointShader) {
+        pointSizeUniform = pointShader.getUniformLocation("size");
+        strokeWidthUniform = strokeShader.getUniformLocation("width");
+        gpuStrokeWidthUniform = gpuStrokeShader.getUniformLocation("width");
     }
-    void Draw(const Shader& lineShader,const Shader& pointShader) const {
+    //a draw call per primitive type and instance bucket, however many curves there are
+    void Draw(const Shader& lineShader,const Shader& gpuLineShader,const Shader& strokeShader,const Shader& gpuStrokeShader,const Shader& pointShader) {
+        PROFILE_SCOPE("draw");
+        PROFILE_GPU_SCOPE(gpuTimer,"draw");
+        const TessellationThread::Frame* frame = asyncFrame();
+        if(asyncTessellation && !frame) {
+            return;
+        }
+        const size_t pointCount = frame ? frame->controlPoints.size() : scene.ControlPoints().size();
+        const CurveScene::Slice* visibleLines = frame ? frame->visibleLines.data() : scene.VisibleLines().data();
+        const size_t visibleLineCount = frame ? frame->visibleLines.size() : scene.VisibleLines().size();
         VAO::bind(points_vao);
         pointShader.use();
-        glPointSize(5);
-        glDrawArrays(GL_POINTS,0,bezierCurve.points.size());
-        
-        VAO::bind(bc_vbo);
-        lineShader.use();
-        glDrawArrays(GL_LINE_STRIP,0,bezierCurve.linePoints.size());
+        pointShader.setFloat(pointSizeUniform,pointSize);
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP,0,4,pointCount);
+
+        const GLint base = bc_stream.offset()/sizeof(glm::vec2);
+        if(strokes) {
+            strokeLines.clear();
+            for(size_t i=0;i<visibleLineCount;i++) {
+                const CurveScene::Slice& line = visibleLines[i];
+                strokeLines.push_back({static_cast<GLint>(base+line.first),static_cast<GLint>(line.count)});
+            }
+            bucketInstances(strokeLines,sortedStrokeLines,[](const StrokeLine& line) { return line.count-1; });
+            if(!sortedStrokeLines.empty()) {
+                VBO::setData(stroke_vbo,sizeof(StrokeLine)*sortedStrokeLines.size(),sortedStrokeLines.data(),GL_STREAM_DRAW);
+                countUpload(sizeof(StrokeLine)*sortedStrokeLines.size());
+                strokeShader.use();
+                strokeShader.setFloat(strokeWidthUniform,strokeWidth);
+                glActiveTexture(GL_TEXTURE0);
+                glBindTexture(GL_TEXTURE_BUFFER,lines_tbo);
+                PROFILE_GPU_SCOPE(gpuTimer,"draw lines");
+                for(const InstanceBucket& bucket : instanceBuckets) {
+                    VAO::addIntAttrib(stroke_vao,0,2,GL_INT,sizeof(StrokeLine),(void*)(sizeof(StrokeLine)*bucket.first));
+                    glDrawArraysInstanced(GL_TRIANGLES,0,6*bucket.segments,bucket.count);
+                }
+            }
+        }else {
+            VAO::bind(bc_vao);
+            lineShader.use();
+            lineFirsts.clear();
+            lineCounts.clear();
+            for(size_t i=0;i<visibleLineCount;i++) {
+                lineFirsts.push_back(base+visibleLines[i].first);
+                lineCounts.push_back(visibleLines[i].count);
+            }
+            if(!lineFirsts.empty()) {
+                PROFILE_GPU_SCOPE(gpuTimer,"draw lines");
+                glMultiDrawArrays(GL_LINE_STRIP,lineFirsts.data(),lineCounts.data(),lineFirsts.size());
+            }
+        }
+        bc_stream.fence();
+
+        if(gpuTessellation) {
+            gpuCurves.clear();
+            if(frame) {
+                for(const TessellationThread::PointCurve& curve : frame->pointCurves) {
+                    gpuCurves.push_back({curve.firstPoint,curve.pointCount,curve.samples});
+                }
+            }else {
+                for(const uint32_t i : scene.VisibleCurves()) {
+                    const BezierCurve& curve = scene.curves[i];
+                    if(scene.LineSlice(i).count>0 || curve.Points().size()<2) {
+                        continue;
+                    }
+                    const GLint samples = CurveScene::LodCount(curve.SampleCount(),scene.Lod(i));
+                    gpuCurves.push_back({static_cast<GLint>(scene.PointSlice(i).first),static_cast<GLint>(curve.Points().size()),samples});
+                }
+            }
+            bucketInstances(gpuCurves,sortedGpuCurves,[](const GpuCurve& curve) { return curve.samples-1; });
+            if(!sortedGpuCurves.empty()) {
+                VBO::setData(gpu_vbo,sizeof(GpuCurve)*sortedGpuCurves.size(),sortedGpuCurves.data(),GL_STREAM_DRAW);
+                countUpload(sizeof(GpuCurve)*sortedGpuCurves.size());
+                glActiveTexture(GL_TEXTURE0);
+                glBindTexture(GL_TEXTURE_BUFFER,points_tbo);
+                PROFILE_GPU_SCOPE(gpuTimer,"draw gpu lines");
+                if(strokes) {
+                    gpuStrokeShader.use();
+                    gpuStrokeShader.setFloat(gpuStrokeWidthUniform,strokeWidth);
+                }else {
+                    gpuLineShader.use();
+                }
+                for(const InstanceBucket& bucket : instanceBuckets) {
+                    VAO::addIntAttrib(gpu_vao,0,3,GL_INT,sizeof(GpuCurve),(void*)(sizeof(GpuCurve)*bucket.first));
+                    if(strokes) {
+                        glDrawArraysInstanced(GL_TRIANGLES,0,6*bucket.segments,bucket.count);
+                    }else {
+                        glDrawArraysInstanced(GL_LINE_STRIP,0,bucket.segments+1,bucket.count);
+                    }
+                }
+            }
+        }
     }
     void HandleMouse() {
         if(mouse.leftPressed) {
-	        if(capturedPoint!=nullptr) {
-	        	*capturedPoint = glm::clamp(mouse.pos, {0,0}, glm::vec2(SCR_WIDTH,SCR_HEIGHT)) ;
-                UpdateCurve();
+	        if(pointCaptured) {
+	        	const BoundingBox view = viewBox();
+	        	const glm::vec2 pos = glm::clamp(mouse.WorldPos(), view.min, view.max);
+                const size_t index = scene.curves[capturedCurve].IndexOf(capturedPoint);
+                if(pos!=scene.curves[capturedCurve].Points()[index]) {//every cursor event since the last frame ends up in this one move
+                    movePoint(capturedCurve,index,pos);
+                    capturedPointMoved = true;
+                }
 	        }
         }else {
-            capturedPoint=nullptr;
+            if(capturedPointMoved) { //drop rounding error accumulated by the incremental updates
+                UpdateCurve(capturedCurve);
+                capturedPointMoved = false;
+            }
+            pointCaptured = false;
         }
     }
+    void NewCurve() {
+        activeCurve = scene.AddCurve();
+        pointCaptured = false;
+    }
     void NewPoint(const glm::vec2 pos) {
-        bezierCurve.points.push_back(pos);
-        capturedPoint = &bezierCurve.points.back();
-        capturedPointIndex = bezierCurve.points.size()-1;
+        capturedCurve = activeCurve;
+        capturedPoint = addPoint(activeCurve,pos);
+        pointCaptured = true;
 	}
     void EraseCapturedPoint() {
-	    if(capturedPoint!=nullptr) {
-            bezierCurve.points.erase(bezierCurve.points.begin()+capturedPointIndex);
-            capturedPoint = nullptr;
-            UpdateCurve();
+	    if(pointCaptured) {
+            BezierCurve& curve = scene.curves[capturedCurve];
+            const glm::vec2 pos = curve.Points()[curve.IndexOf(capturedPoint)];
+            pointGrid.Erase({static_cast<size_t>(capturedCurve),capturedPoint,pos},pos,pos);
+            curve.ErasePoint(capturedPoint);
+            pointCaptured = false;
+            UpdateCurve(capturedCurve);
 	    }
     }
-    void CheckCapturePoint() {
-        int closestPoint = 0;
-        float closestDist = FLT_MAX;
-        for(int i=0;i<bezierCurve.points.size();i++) {
-            const float dist = glm::distance(mouse.pos,bezierCurve.points[i]);
-            if(dist < closestDist) {
-                closestDist = dist;
-                closestPoint = i;
+    //precision of the finest level of detail, zooming picks coarser ones without tessellating again
+    void ScalePrecision(const float factor) {
+        for(BezierCurve& curve : scene.curves) {
+            curve.SetPrecision(curve.GetPrecision()*factor);
+        }
+        UpdateAll();
+    }
+    void CycleEvaluationMode() {
+        using Mode = BezierCurve::EvaluationMode;
+        Mode mode = Mode::Bernstein;
+        switch(scene.curves[activeCurve].GetEvaluationMode()) {
+        case Mode::DeCasteljau:
+            mode = Mode::Bernstein;
+            std::cout << "Evaluation mode: Bernstein" << std::endl;
+            break;
+        case Mode::Bernstein:
+            mode = Mode::ForwardDifference;
+            std::cout << "Evaluation mode: Forward difference" << std::endl;
+            break;
+        case Mode::ForwardDifference:
+            mode = Mode::DeCasteljau;
+            std::cout << "Evaluation mode: De Casteljau" << std::endl;
+            break;
+        }
+        for(BezierCurve& curve : scene.curves) {
+            curve.SetEvaluationMode(mode);
+        }
+        UpdateAll();
+    }
+    void CycleScalarBackend() {
+        using Backend = BezierCurve::ScalarBackend;
+        Backend backend = Backend::Float;
+        const char* name = "float";
+        switch(scene.curves[activeCurve].GetScalarBackend()) {
+        case Backend::Float:
+            backend = Backend::Double;
+            name = "double";
+            break;
+        case Backend::Double:
+            backend = Backend::Fixed;
+            name = "fixed point";
+            break;
+        case Backend::Fixed:
+            break;
+        }
+        for(BezierCurve& curve : scene.curves) {
+            curve.SetScalarBackend(backend);
+        }
+        UpdateAll();
+        std::cout << "Scalar backend: " << name << ", max error of the active curve "
+                  << scene.curves[activeCurve].MaxError(backend) << std::endl;
+    }
+    void CycleTessellationMode() {
+        using Mode = BezierCurve::TessellationMode;
+        Mode mode = Mode::Uniform;
+        const char* name = "uniform";
+        switch(scene.curves[activeCurve].GetTessellationMode()) {
+        case Mode::Uniform:
+            mode = Mode::Adaptive;
+            name = "adaptive";
+            break;
+        case Mode::Adaptive:
+            mode = Mode::ArcLength;
+            name = "equal arc length";
+            break;
+        case Mode::ArcLength:
+            break;
+        }
+        for(BezierCurve& curve : scene.curves) {
+            curve.SetTessellationMode(mode);
+        }
+        UpdateAll();
+        Update();
+        if(asyncTessellation) {//waits for the thread once, only to report what it did
+            tessellator.Flush();
+            Update();
+        }
+        const TessellationThread::Frame* frame = asyncFrame();
+        const size_t vertexCount = frame ? frame->vertices.size() : scene.Vertices().size();
+        std::cout << "Tessellation: " << name << ", " << vertexCount << " vertices, "
+                  << (frame ? frame->tessellationMicroseconds : scene.TessellationMicroseconds()) << " us, " << vertexCount*sizeof(glm::vec2) << " bytes uploaded" << std::endl;
+    }
+    //the cpu lines stay the reference, the gpu path only uploads control points
+    void ToggleStrokes() {
+        strokes = !strokes;
+        Redraw::Request();
+        std::cout << (strokes ? "Strokes" : "Hairlines") << std::endl;
+    }
+    void ScaleStrokeWidth(const float factor) {
+        strokeWidth = std::clamp(strokeWidth*factor,minStrokeWidth,maxStrokeWidth);
+        Redraw::Request();
+    }
+    //switching back tessellates everything on this thread once, the thread's frames are about a scene it doesn't have
+    void ToggleAsyncTessellation() {
+        asyncTessellation = !asyncTessellation;
+        lineGridRevisions.clear();
+        if(asyncTessellation) {
+            startAsync();
+        }else {
+            tessellator.Stop();
+            scene.MarkAllDirty();
+            pointsStale = true;
+            linesChanged = true;
+            bc_stream.invalidateAll();
+            Redraw::Request();
+        }
+        std::cout << "Tessellation " << (asyncTessellation ? "on its own thread" : "in the frame") << std::endl;
+    }
+    //before glfwTerminate, the thread wakes the loop through glfw after every frame
+    void Shutdown() {
+        tessellator.Stop();
+    }
+    //before Init, which starts the thread when it is on
+    void SetAsyncTessellation(const bool async) {
+        asyncTessellation = async;
+    }
+    size_t TakeUploadedBytes() {
+        const size_t bytes = uploadedBytes;
+        uploadedBytes = 0;
+        return bytes;
+    }
+    //one frame of a script, its indices wrap around the curves and points there are
+    void Play(const EditScript::Step& step) {
+        const size_t curve = step.curve==EditScript::lastCurve ? scene.curves.size()-1 : step.curve%scene.curves.size();
+        switch(step.kind) {
+        case EditScript::Kind::Wait:
+            break;
+        case EditScript::Kind::Drag: {
+            const std::pmr::vector<glm::vec2>& points = scene.curves[curve].Points();
+            if(!points.empty()) {
+                const size_t index = step.point%points.size();
+                movePoint(curve,index,points[index]+step.value);
             }
+            break;
+        }
+        case EditScript::Kind::Insert:
+            addPoint(curve,step.value);
+            break;
+        case EditScript::Kind::NewCurve:
+            NewCurve();
+            break;
+        case EditScript::Kind::Precision:
+            ScalePrecision(step.factor);
+            break;
+        }
+    }
+    void ToggleGpuTessellation() {
+        gpuTessellation = !gpuTessellation;
+        scene.SetMinLinePoints(gpuTessellation ? maxGpuPoints+1 : 0);
+        Redraw::Request();
+        std::cout << "Tessellation on the " << (gpuTessellation ? "gpu" : "cpu") << std::endl;
+    }
+    //the nearest control point within pointCaptureDistance pixels, otherwise a click on a line makes its curve the active one
+    void CheckCapturePoint() {
+        const glm::vec2 pos = mouse.WorldPos();
+        const float radius = pointCaptureDistance/viewZoom;
+        fitPickGrids(radius);
+        PickPoint nearest{};
+        float distance = 0.0f;
+        if(pointGrid.Nearest(pos,radius,[pos](const PickPoint& p) { return glm::distance(pos,p.pos); },nearest,distance)) {
+            capturedCurve = nearest.curve;
+            capturedPoint = nearest.handle;
+            pointCaptured = true;
+            activeCurve = nearest.curve;
+            return;
         }
-        if(closestDist<=pointCaptureDistance) {
-            capturedPointIndex = closestPoint;
-            capturedPoint = &bezierCurve.points[closestPoint];
+        updateLineGrid();
+        LineGrid::Hit hit;
+        if(lineGrid.Nearest(pos,radius,hit)) {
+            activeCurve = hit.curve;
         }
     }
 };
 BezierCurveVisualizer bcVisualizer;
 
-glm::mat4 projection = glm::ortho(0.0f,SCR_WIDTH,SCR_HEIGHT,0.0f);
+#if BEZIER_PROFILE
+//cpu and gpu time of the last frames as a graph in the bottom left corner, section averages in the window title
+class ProfilerOverlay {
+    GLuint vbo = 0;
+    GLuint vao = 0;
+    std::vector<glm::vec2> vertices;
+    std::vector<GLint> firsts;
+    std::vector<GLsizei> counts;
+    double lastTitle = 0.0;
+    const float pixelsPerMillisecond = 6.0f;
+    const float pixelsPerFrame = 2.0f;
+    const size_t titleFrames = 60;
+    //one strip with a vertex per completed frame, negative times (no gpu result) are left out
+    template<class Time>
+    void addGraph(Time time) {
+        const float bottom = SCR_HEIGHT-10.0f;
+        const size_t frames = Profiler::CompletedFrames();
+        firsts.push_back(vertices.size());
+        for(size_t age=frames;age-->0;) {
+            const double us = time(Profiler::CompletedFrame(age));
+            if(us>=0.0) {
+                vertices.push_back({10.0f+pixelsPerFrame*(frames-1-age),bottom-static_cast<float>(us/1000.0)*pixelsPerMillisecond});
+            }
+        }
+        counts.push_back(vertices.size()-firsts.back());
+    }
+    void updateTitle(GLFWwindow* window) {
+        const size_t frames = std::min(titleFrames,Profiler::CompletedFrames());
+        if(frames==0) {
+            return;
+        }
+        std::ostringstream title;
+        title << std::fixed << std::setprecision(2) << "Bezier Curve Simulator";
+        for(size_t section=0;section<Profiler::SectionCount();section++) {
+            double cpu = 0.0;
+            double gpu = 0.0;
+            size_t gpuFrames = 0;
+            for(size_t age=0;age<frames;age++) {
+                const Profiler::Frame& frame = Profiler::CompletedFrame(age);
+                cpu += frame.cpu[section];
+                if(frame.gpu[section]>=0.0) {
+                    gpu += frame.gpu[section];
+                    gpuFrames++;
+                }
+            }
+            title << " | " << Profiler::SectionName(section) << " " << cpu/frames/1000.0;
+            if(gpuFrames>0) {
+                title << " gpu " << gpu/gpuFrames/1000.0;
+            }
+        }
+        int64_t allocations = 0;
+        for(size_t age=0;age<frames;age++) {
+            allocations += Profiler::CompletedFrame(age).counters[0];
+        }
+        title << " ms | " << allocations/static_cast<int64_t>(frames) << " allocations/frame";
+        glfwSetWindowTitle(window,title.str().c_str());
+    }
+public:
+    bool visible = false;
+    void Init() {
+        VBO::generate(vbo);
+        VBO::bind(vbo);
+        VAO::generate(vao);
+        VAO::addAttrib(vao,0,2,GL_FLOAT,GL_FALSE,2 * sizeof(float),(void*)0);
+    }
+    void Toggle(GLFWwindow* window) {
+        visible = !visible;
+        if(!visible) {
+            glfwSetWindowTitle(window,"Bezier Curve Simulator");
+        }
+        Redraw::Request();
+    }
+    void Draw(GLFWwindow* window, const Shader& lineShader, const GLint projectionUniform) {
+        if(!visible) {
+            return;
+        }
+        if(glfwGetTime()-lastTitle>1.0) {
+            lastTitle = glfwGetTime();
+            updateTitle(window);
+        }
+        vertices.clear();
+        firsts.clear();
+        counts.clear();
+        //60 and 30 fps budgets
+        for(const float ms : {1000.0f/60.0f,1000.0f/30.0f}) {
+            const float y = SCR_HEIGHT-10.0f-ms*pixelsPerMillisecond;
+            firsts.push_back(vertices.size());
+            counts.push_back(2);
+            vertices.push_back({10.0f,y});
+            vertices.push_back({10.0f+pixelsPerFrame*Profiler::historyFrames,y});
+        }
+        const size_t frameSection = Profiler::Section("frame");
+        const size_t drawSection = Profiler::Section("draw");
+        addGraph([frameSection](const Profiler::Frame& frame) { return frame.cpu[frameSection]; });
+        addGraph([drawSection](const Profiler::Frame& frame) { return frame.gpu[drawSection]; });
+        VBO::setData(vbo,sizeof(glm::vec2)*vertices.size(),vertices.data(),GL_STREAM_DRAW);
+        VAO::bind(vao);
+        lineShader.use();
+        lineShader.setMat4(projectionUniform,glm::ortho(0.0f,SCR_WIDTH,SCR_HEIGHT,0.0f));
+        glMultiDrawArrays(GL_LINE_STRIP,firsts.data(),counts.data(),firsts.size());
+        lineShader.setMat4(projectionUniform,projection);
+    }
+    //profile.csv and profile.trace.json in the working directory
+    void Export() const {
+        std::ofstream csv("profile.csv");
+        Profiler::WriteCsv(csv);
+        std::ofstream trace("profile.trace.json");
+        Profiler::WriteChromeTrace(trace);
+        std::cout << "Wrote profile.csv and profile.trace.json (" << Profiler::CompletedFrames() << " frames)" << std::endl;
+    }
+};
+ProfilerOverlay profilerOverlay;
+#endif
+
+//rendering into a FrameBuffer under an invisible window, a script stands in for the mouse and frames follow each other as fast as they can
+struct HeadlessOptions {
+    bool enabled = false;
+    //0 for as many as the script has, the script starts over when it is shorter
+    size_t frames = 0;
+    std::string script;
+    //png files go there, every pngEvery frames or only the last one for 0
+    std::string pngDirectory;
+    size_t pngEvery = 0;
+    //off by default, frames then show exactly the edits up to them and the images don't depend on timing
+    bool asyncTessellation = false;
+    //egl or osmesa instead of the platform's context api, for machines without a display server
+    std::string contextApi;
+};
+
+//frame times include glFinish, with nothing shown there is no swap that would wait for the gpu
+int runHeadless(const HeadlessOptions& options, const std::function<void()>& drawFrame) {
+    EditScript script;
+    if(options.script.empty()) {
+        script = EditScript::Synthetic(options.frames>0 ? options.frames : 600);
+    }else if(!script.Load(options.script)) {
+        std::cout << "Script not loaded: " << script.Error() << std::endl;
+        return 1;
+    }
+    const size_t frames = options.frames>0 ? options.frames : script.FrameCount();
+    FrameBuffer target;
+    if(!target.create(static_cast<GLsizei>(SCR_WIDTH),static_cast<GLsizei>(SCR_HEIGHT))) {
+        std::cout << "Offscreen framebuffer incomplete" << std::endl;
+        return 1;
+    }
+    target.bind();
+    glViewport(0,0,target.getWidth(),target.getHeight());
+
+    std::vector<double> frameMilliseconds;
+    frameMilliseconds.reserve(frames);
+    std::vector<uint8_t> pixels;
+    size_t uploadedBytes = 0;
+    size_t imagesWritten = 0;
+    bcVisualizer.TakeUploadedBytes();//the initial upload isn't part of any frame
+    for(size_t i=0;i<frames;i++) {
+        const auto start = std::chrono::steady_clock::now();
+        Time::Update();
+        if(script.FrameCount()>0) {
+            bcVisualizer.Play(script.Frame(i%script.FrameCount()));
+        }
+        drawFrame();
+        glFinish();
+        frameMilliseconds.push_back(std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-start).count());
+        uploadedBytes += bcVisualizer.TakeUploadedBytes();
+        glfwPollEvents();//the tessellation thread posts an event per frame
+
+        const bool last = i+1==frames;
+        if(!options.pngDirectory.empty() && (last || (options.pngEvery>0 && (i+1)%options.pngEvery==0))) {
+            target.readPixels(pixels);
+            std::ostringstream path;
+            path << options.pngDirectory << "/frame_" << std::setw(6) << std::setfill('0') << i+1 << ".png";
+            if(PngWriter::Write(path.str(),pixels.data(),target.getWidth(),target.getHeight(),true)) {
+                imagesWritten++;
+            }else {
+                std::cout << "Image not written: " << path.str() << std::endl;
+            }
+        }
+    }
+    target.unbind();
+    target.destroy();
+    if(frames==0) {
+        std::cout << "Headless: no frames" << std::endl;
+        return 0;
+    }
+
+    double total = 0.0;
+    for(const double ms : frameMilliseconds) {
+        total += ms;
+    }
+    std::sort(frameMilliseconds.begin(),frameMilliseconds.end());
+    //nearest rank
+    const auto percentile = [&frameMilliseconds](const double p) {
+        const size_t rank = static_cast<size_t>(std::ceil(p*frameMilliseconds.size()));
+        return frameMilliseconds[std::clamp<size_t>(rank,1,frameMilliseconds.size())-1];
+    };
+    std::cout << std::fixed << std::setprecision(3)
+              << "Headless: " << frames << " frames, " << 1000.0*frames/total << " frames/s, "
+              << static_cast<double>(uploadedBytes)/frames << " bytes uploaded per frame, "
+              << "frame time p50 " << percentile(0.5) << " ms, p99 " << percentile(0.99) << " ms" << std::endl;
+    if(imagesWritten>0) {
+        std::cout << "Wrote " << imagesWritten << " images to " << options.pngDirectory << std::endl;
+    }
+    return 0;
+}
+
+//usage: "Bezier Curves" [scene.bzs] [--headless] [--frames n] [--script edits.txt] [--png directory] [--png-every n] [--async] [--context egl|osmesa]
+//S saves the scene to scene.bzs, the options after the scene only matter for --headless
+int main(int argc, char** argv) {
+    std::string scenePath;
+    HeadlessOptions headless;
+    for(int i=1;i<argc;i++) {
+        const std::string arg = argv[i];
+        const bool hasValue = i+1<argc;
+        if(arg=="--headless") {
+            headless.enabled = true;
+        }else if(arg=="--async") {
+            headless.asyncTessellation = true;
+        }else if(arg=="--frames" && hasValue) {
+            headless.frames = std::strtoull(argv[++i],nullptr,10);
+        }else if(arg=="--script" && hasValue) {
+            headless.script = argv[++i];
+        }else if(arg=="--png" && hasValue) {
+            headless.pngDirectory = argv[++i];
+        }else if(arg=="--png-every" && hasValue) {
+            headless.pngEvery = std::strtoull(argv[++i],nullptr,10);
+        }else if(arg=="--context" && hasValue) {
+            headless.contextApi = argv[++i];
+        }else if(arg.rfind("--",0)==0) {
+            std::cout << "Unknown option " << arg << std::endl;
+            return 1;
+        }else {
+            scenePath = arg;
+        }
+    }
 
-int main() {
     // glfw: initialize and configure
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);//opengl versions
@@ -136,6 +1077,14 @@ int main() {
 #ifdef __APPLE__
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
+    if(headless.enabled) {
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        if(headless.contextApi=="egl") {
+            glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+        }else if(headless.contextApi=="osmesa") {//software rendering like llvmpipe, needs a glfw built with OSMesa
+            glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_OSMESA_CONTEXT_API);
+        }
+    }
 
     GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Bezier Curve Simulator", NULL, NULL);
     if (window == NULL) {
@@ -150,7 +1099,8 @@ int main() {
     glfwSetMouseButtonCallback(window, mouse_button_callback);
     glfwSetScrollCallback(window, mouse_scroll_callback);
     glfwSetKeyCallback(window, key_callback);
-    glfwSwapInterval(0);//VSync 
+    glfwSetWindowRefreshCallback(window, window_refresh_callback);
+    glfwSwapInterval(headless.enabled ? 0 : 1);//VSync, frames are only drawn when something changed anyway, headless ones are never shown
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
     //glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);//capture mouse
 
@@ -158,51 +1108,109 @@ int main() {
         std::cout << "Failed to initialize GLAD" << std::endl;
         return -1;
     }
+    GLExt::load((GLADloadproc)glfwGetProcAddress);
 
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glEnable(GL_LINE_SMOOTH);
-    glHint(GL_LINE_SMOOTH_HINT, GL_NICEST);
 
     Time::Init();
 
     glm::mat4 model = glm::mat4(1.0f);
 
     Shader lineShader("resources/shaders/lineShader_vs.glsl", "resources/shaders/lineShader_fs.glsl");
+    Shader gpuLineShader("resources/shaders/lineShader_gpu_vs.glsl", "resources/shaders/lineShader_fs.glsl");
+    Shader strokeShader("resources/shaders/stroke_vs.glsl", "resources/shaders/stroke_fs.glsl");
+    Shader gpuStrokeShader("resources/shaders/stroke_gpu_vs.glsl", "resources/shaders/stroke_fs.glsl");
     Shader pointShader("resources/shaders/point_vs.glsl", "resources/shaders/point_fs.glsl");
-    lineShader.use();
-    lineShader.setVec2("res",SCR_WIDTH,SCR_HEIGHT);
-    lineShader.setMat4("projection",projection);
-    lineShader.setMat4("model",model);
-    pointShader.use();
-    pointShader.setVec2("res",SCR_WIDTH,SCR_HEIGHT);
-    pointShader.setMat4("projection",projection);
-    pointShader.setMat4("model",model);
+    //res and projection change with the window, resolved once here instead of looked up on every resize
+    struct ViewUniforms {
+        const Shader& shader;
+        GLint res;
+        GLint projection;
+    };
+    const ViewUniforms viewUniforms[] = {
+        {lineShader,lineShader.getUniformLocation("res"),lineShader.getUniformLocation("projection")},
+        {gpuLineShader,gpuLineShader.getUniformLocation("res"),gpuLineShader.getUniformLocation("projection")},
+        {strokeShader,strokeShader.getUniformLocation("res"),strokeShader.getUniformLocation("projection")},
+        {gpuStrokeShader,gpuStrokeShader.getUniformLocation("res"),gpuStrokeShader.getUniformLocation("projection")},
+        {pointShader,pointShader.getUniformLocation("res"),pointShader.getUniformLocation("projection")},
+    };
+    for(const ViewUniforms& view : viewUniforms) {
+        view.shader.use();
+        view.shader.setVec2(view.res,SCR_WIDTH,SCR_HEIGHT);
+        view.shader.setMat4(view.projection,projection);
+        view.shader.setMat4("model",model);
+    }
+    gpuLineShader.use();
+    gpuLineShader.setInt("controlPoints",0);
+    strokeShader.use();
+    strokeShader.setInt("linePoints",0);
+    gpuStrokeShader.use();
+    gpuStrokeShader.setInt("controlPoints",0);
+    bcVisualizer.ResolveUniforms(strokeShader,gpuStrokeShader,pointShader);
 
     shader_viewpoint_callback = [&]() {
-        lineShader.use();
-        lineShader.setVec2("res",SCR_WIDTH,SCR_HEIGHT);
-        lineShader.setMat4("projection",projection);
-        pointShader.use();
-        pointShader.setVec2("res",SCR_WIDTH,SCR_HEIGHT);
-        pointShader.setMat4("projection",projection);
+        for(const ViewUniforms& view : viewUniforms) {
+            view.shader.use();
+            view.shader.setVec2(view.res,SCR_WIDTH,SCR_HEIGHT);
+            view.shader.setMat4(view.projection,projection);
+        }
     };
 
-    bcVisualizer.Init();
+    if(headless.enabled) {
+        bcVisualizer.SetAsyncTessellation(headless.asyncTessellation);
+    }
+    bcVisualizer.Init(scenePath);
+#if BEZIER_PROFILE
+    gpuTimer.create();
+    profilerOverlay.Init();
+    std::cout << "Profiler: O toggles the overlay, P exports, gpu timer queries " << (gpuTimer.isAvailable() ? "available" : "unavailable") << std::endl;
+#endif
+    const auto drawFrame = [&]() {
+        PROFILE_FRAME();
+#if BEZIER_PROFILE
+        gpuTimer.beginFrame(Profiler::FrameNumber());
+#endif
+        PROFILE_SCOPE("frame");
+        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        bcVisualizer.Update();
+        bcVisualizer.Draw(lineShader,gpuLineShader,strokeShader,gpuStrokeShader,pointShader);
+    };
+    if(headless.enabled) {
+        const int result = runHeadless(headless,drawFrame);
+        bcVisualizer.Shutdown();
+#if BEZIER_PROFILE
+        gpuTimer.destroy();
+#endif
+        glfwTerminate();
+        return result;
+    }
 
+    //input and edits request frames, without them the loop sleeps
     while (!glfwWindowShouldClose(window)) {
+        Redraw::WaitEvents();
         Time::Update();
-        //processInput(window);// input
 
-        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
-
-        bcVisualizer.Draw(lineShader,pointShader);
         bcVisualizer.HandleMouse();
-
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        if(!Redraw::BeginFrame()) {
+            continue;
+        }
+        drawFrame();
+#if BEZIER_PROFILE
+        profilerOverlay.Draw(window,lineShader,viewUniforms[0].projection);
+#endif
+        {
+            PROFILE_SCOPE("swap");
+            glfwSwapBuffers(window);
+        }
     }
+    std::cout << "Frames drawn: " << Redraw::framesDrawn << ", idle wakeups: " << Redraw::framesSkipped << std::endl;
+    bcVisualizer.Shutdown();
+#if BEZIER_PROFILE
+    gpuTimer.destroy();
+#endif
 
     glfwTerminate();
     return 0;
@@ -221,6 +1229,44 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
     if(key == GLFW_KEY_DELETE && action == GLFW_PRESS) {
     	bcVisualizer.EraseCapturedPoint();
     }
+    if(key == GLFW_KEY_E && action == GLFW_PRESS) {
+        bcVisualizer.CycleEvaluationMode();
+    }
+    if(key == GLFW_KEY_B && action == GLFW_PRESS) {
+        bcVisualizer.CycleScalarBackend();
+    }
+    if(key == GLFW_KEY_T && action == GLFW_PRESS) {
+        bcVisualizer.CycleTessellationMode();
+    }
+    if(key == GLFW_KEY_N && action == GLFW_PRESS) {
+        bcVisualizer.NewCurve();
+    }
+    if(key == GLFW_KEY_G && action == GLFW_PRESS) {
+        bcVisualizer.ToggleGpuTessellation();
+    }
+    if(key == GLFW_KEY_A && action == GLFW_PRESS) {
+        bcVisualizer.ToggleAsyncTessellation();
+    }
+    if(key == GLFW_KEY_L && action == GLFW_PRESS) {
+        bcVisualizer.ToggleStrokes();
+    }
+    if(key == GLFW_KEY_LEFT_BRACKET && action == GLFW_PRESS) {
+        bcVisualizer.ScaleStrokeWidth(0.5f);
+    }
+    if(key == GLFW_KEY_RIGHT_BRACKET && action == GLFW_PRESS) {
+        bcVisualizer.ScaleStrokeWidth(2.0f);
+    }
+    if(key == GLFW_KEY_S && action == GLFW_PRESS) {
+        bcVisualizer.SaveScene("scene.bzs");
+    }
+#if BEZIER_PROFILE
+    if(key == GLFW_KEY_O && action == GLFW_PRESS) {
+        profilerOverlay.Toggle(window);
+    }
+    if(key == GLFW_KEY_P && action == GLFW_PRESS) {
+        profilerOverlay.Export();
+    }
+#endif
 }
 
 void mouse_cursor_callback(GLFWwindow* window, double xpos, double ypos) {
@@ -233,6 +1279,10 @@ void mouse_cursor_callback(GLFWwindow* window, double xpos, double ypos) {
         mouse.firstInput = false;
     }
 
+    if(mouse.rightPressed) {//drag the view
+        viewOffset -= (glm::vec2(xposIn,yposIn)-mouse.pos)/viewZoom;
+        updateProjection();
+    }
     mouse.pos.x = xposIn;
     mouse.pos.y = yposIn;
 }
@@ -244,30 +1294,41 @@ void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
     if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS) {
         mouse.leftPressed = true;
         bcVisualizer.CheckCapturePoint();
-        if(Time::time-lastClick <= doubleClickSpeed) { // double click
-            bcVisualizer.NewPoint(mouse.pos);
-            bcVisualizer.UpdateCurve();
+        //Time::time is from before the loop went to sleep
+        const double now = glfwGetTime();
+        if(now-lastClick <= doubleClickSpeed) { // double click
+            bcVisualizer.NewPoint(mouse.WorldPos());
         }else{
-            lastClick = Time::time;
+            lastClick = now;
         }
     }
     if(button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_RELEASE) {
         mouse.leftPressed = false;
     }
+    if(button == GLFW_MOUSE_BUTTON_RIGHT) {
+        mouse.rightPressed = action == GLFW_PRESS;
+    }
 }
 
 void mouse_scroll_callback(GLFWwindow* window, double xoffset, double yoffset) {
     if(glfwGetKey(window,GLFW_KEY_LEFT_CONTROL) == GLFW_PRESS) {
-        bcVisualizer.bezierCurve.SetPrecision(bcVisualizer.bezierCurve.GetPrecision()*(1+0.1f*yoffset));
-        bcVisualizer.bezierCurve.RecalculateLine();
-        bcVisualizer.UpdateCurve();
+        bcVisualizer.ScalePrecision(1+0.1f*yoffset);
+        return;
     }
+    //zoom about the cursor, the world position under it stays put
+    const glm::vec2 anchor = mouse.WorldPos();
+    viewZoom = glm::clamp(viewZoom*(1.0f+0.1f*static_cast<float>(yoffset)),0.01f,100.0f);
+    viewOffset = anchor-mouse.pos/viewZoom;
+    updateProjection();
 }
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
 	SCR_WIDTH = width;
 	SCR_HEIGHT = height;
 	glViewport(0, 0, width, height); //0,0 - left bottom
-	projection = glm::ortho(0.0f,SCR_WIDTH,SCR_HEIGHT,0.0f);
-	shader_viewpoint_callback();
+	updateProjection();
+}
+
+void window_refresh_callback(GLFWwindow* window) {
+	Redraw::Request();
 }
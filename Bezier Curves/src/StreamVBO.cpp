@@ -0,0 +1,126 @@
+#include "../include/StreamVBO.h"
+
+#include <algorithm>
+
+namespace {
+	//keeps every region start aligned for GL_MIN_MAP_BUFFER_ALIGNMENT and whole vertices
+	const GLsizeiptr regionAlignment = 256;
+	const GLbitfield persistentFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+}
+
+void StreamVBO::create(GLsizeiptr regionSize) {
+	allocate(regionSize);
+}
+
+void StreamVBO::destroy() {
+	for(GLsync& sync : fences) {
+		if(sync!=nullptr) {
+			glDeleteSync(sync);
+			sync = nullptr;
+		}
+	}
+	if(id!=0) {
+		if(mapped!=nullptr) {
+			VBO::bind(id);
+			glUnmapBuffer(GL_ARRAY_BUFFER);
+			mapped = nullptr;
+		}
+		VBO::deleteIt(id);
+		id = 0;
+	}
+}
+
+void StreamVBO::allocate(GLsizeiptr regionSize) {
+	destroy();//the driver keeps the old storage alive until pending draws finished
+	size = std::max<GLsizeiptr>((regionSize+regionAlignment-1)/regionAlignment*regionAlignment, regionAlignment);
+	current = regionCount-1;
+	contentSize = -1;
+	VBO::generate(id);
+	VBO::bind(id);
+	persistent = GLExt::hasBufferStorage();
+	if(persistent) {
+		GLExt::bufferStorage(GL_ARRAY_BUFFER, size*regionCount, nullptr, persistentFlags);
+		mapped = static_cast<char*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, size*regionCount, persistentFlags));
+		persistent = mapped!=nullptr;
+	}else {
+		glBufferData(GL_ARRAY_BUFFER, size*regionCount, nullptr, GL_STREAM_DRAW);
+	}
+}
+
+void StreamVBO::wait(int region) {
+	GLsync& sync = fences[region];
+	if(sync==nullptr) {
+		return;
+	}
+	GLenum status = GL_TIMEOUT_EXPIRED;
+	while(status==GL_TIMEOUT_EXPIRED) {
+		status = glClientWaitSync(sync, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);//1 ms steps
+	}
+	glDeleteSync(sync);
+	sync = nullptr;
+}
+
+void StreamVBO::invalidate(const GLintptr first, const GLsizeiptr count) {
+	if(count<=0) {
+		return;
+	}
+	for(Range& range : stale) {
+		if(range.count==0) {
+			range = {first, count};
+		}else {
+			const GLintptr end = std::max(range.first+range.count, first+count);
+			range.first = std::min(range.first, first);
+			range.count = end-range.first;
+		}
+	}
+}
+
+void StreamVBO::invalidateAll() {
+	contentSize = -1;
+}
+
+GLsizeiptr StreamVBO::write(const void* data, const GLsizeiptr bytes) {
+	if(bytes>size) {
+		allocate(std::max(bytes, size*2));
+	}
+	if(bytes!=contentSize) {
+		for(Range& range : stale) {
+			range = {0, bytes};
+		}
+		contentSize = bytes;
+	}
+	current = (current+1)%regionCount;
+	wait(current);
+	const GLintptr first = std::min<GLintptr>(stale[current].first, bytes);
+	const GLsizeiptr count = std::min<GLsizeiptr>(stale[current].count, bytes-first);
+	stale[current] = {};
+	if(count<=0) {
+		return 0;
+	}
+	const char* source = static_cast<const char*>(data)+first;
+	if(persistent) {
+		std::copy(source, source+count, mapped+offset()+first);
+		return count;
+	}
+	//only the stale range is mapped, invalidating the whole region would lose the rest of it
+	VBO::bind(id);
+	char* target = static_cast<char*>(glMapBufferRange(GL_ARRAY_BUFFER, offset()+first, count, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT));
+	std::copy(source, source+count, target);
+	glUnmapBuffer(GL_ARRAY_BUFFER);
+	return count;
+}
+
+GLintptr StreamVBO::offset() const {
+	return size*current;
+}
+
+void StreamVBO::fence() {
+	if(fences[current]!=nullptr) {
+		glDeleteSync(fences[current]);
+	}
+	fences[current] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+bool StreamVBO::isPersistent() const {
+	return persistent;
+}
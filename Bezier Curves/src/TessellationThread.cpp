@@ -0,0 +1,307 @@
+#include "../include/TessellationThread.h"
+
+#include <algorithm>
+
+namespace {
+	void unite(CurveScene::Slice& range, const size_t first, const size_t count) {
+		if(count==0) {
+			return;
+		}
+		if(range.count==0) {
+			range = {first,count};
+			return;
+		}
+		const size_t end = std::max(range.first+range.count,first+count);
+		range.first = std::min(range.first,first);
+		range.count = end-range.first;
+	}
+}
+
+bool TessellationThread::Frame::ChangesSince(const uint64_t revision, CurveScene::Slice& range) const {
+	range = {};
+	if(revision==vertexRevision) {
+		return true;
+	}
+	if(revision>vertexRevision || vertexChanges.empty() || vertexChanges.front().revision>revision+1) {
+		return false;
+	}
+	for(const VertexChange& change : vertexChanges) {
+		if(change.revision>revision) {
+			unite(range,change.range.first,change.range.count);
+		}
+	}
+	return true;
+}
+
+TessellationThread::TessellationThread(ThreadPool& pool, std::function<void()> onFrame):pool(pool),onFrame(std::move(onFrame)) {}
+
+TessellationThread::~TessellationThread() {
+	Stop();
+}
+
+void TessellationThread::Start() {
+	if(thread.joinable()) {
+		return;
+	}
+	stop = false;
+	thread = std::thread(&TessellationThread::workerLoop,this);
+}
+
+void TessellationThread::Stop() {
+	if(!thread.joinable()) {
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		stop = true;
+	}
+	wake.notify_one();
+	thread.join();
+}
+
+bool TessellationThread::IsRunning() const {
+	return thread.joinable();
+}
+
+TessellationThread::Edit* TessellationThread::beginEdit(const EditKind kind) {
+	Edit* edit = queue.BeginPush();
+	if(edit) {
+		edit->kind = kind;
+		edit->sequence = submitted+1;
+	}
+	return edit;
+}
+
+//a worker that saw the queue empty has set sleeping before, so one of the two sides always sees the other's write
+void TessellationThread::endEdit() {
+	submitted++;
+	queue.EndPush();
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if(sleeping.load(std::memory_order_relaxed)) {
+		{
+			std::lock_guard<std::mutex> lock(sleepMutex);//it may be between its check and its wait
+		}
+		wake.notify_one();
+	}
+}
+
+bool TessellationThread::SubmitCurve(const size_t curve, const BezierCurve& source) {
+	Edit* edit = beginEdit(EditKind::Curve);
+	if(!edit) {
+		return false;
+	}
+	edit->curve = static_cast<uint32_t>(curve);
+	edit->points.assign(source.Points().begin(),source.Points().end());
+	edit->precision = source.GetPrecision();
+	edit->flatnessTolerance = source.GetFlatnessTolerance();
+	edit->evaluationMode = source.GetEvaluationMode();
+	edit->tessellationMode = source.GetTessellationMode();
+	edit->scalarBackend = source.GetScalarBackend();
+	endEdit();
+	return true;
+}
+
+bool TessellationThread::SubmitMovePoint(const size_t curve, const size_t index, const glm::vec2 pos) {
+	Edit* edit = beginEdit(EditKind::MovePoint);
+	if(!edit) {
+		return false;
+	}
+	edit->curve = static_cast<uint32_t>(curve);
+	edit->point = static_cast<uint32_t>(index);
+	edit->pos = pos;
+	endEdit();
+	return true;
+}
+
+bool TessellationThread::SubmitView(const BoundingBox& view, const float pixelsPerUnit) {
+	Edit* edit = beginEdit(EditKind::View);
+	if(!edit) {
+		return false;
+	}
+	edit->view = view;
+	edit->pixelsPerUnit = pixelsPerUnit;
+	endEdit();
+	return true;
+}
+
+bool TessellationThread::SubmitMinLinePoints(const size_t points) {
+	Edit* edit = beginEdit(EditKind::MinLinePoints);
+	if(!edit) {
+		return false;
+	}
+	edit->minLinePoints = points;
+	endEdit();
+	return true;
+}
+
+void TessellationThread::Flush() {
+	while(IsRunning() && published.load(std::memory_order_acquire)<submitted) {
+		std::this_thread::yield();
+	}
+}
+
+bool TessellationThread::Acquire() {
+	if(!(ready.load(std::memory_order_relaxed) & freshBit)) {
+		return false;
+	}
+	front = ready.exchange(front,std::memory_order_acq_rel) & indexMask;
+	acquired = true;
+	return true;
+}
+
+const TessellationThread::Frame* TessellationThread::Current() const {
+	return acquired ? &frames[front] : nullptr;
+}
+
+uint64_t TessellationThread::FramesPublished() const {
+	return framesPublished.load(std::memory_order_relaxed);
+}
+
+uint64_t TessellationThread::SupersededEdits() const {
+	return superseded.load(std::memory_order_relaxed);
+}
+
+void TessellationThread::apply(const Edit& edit, CurveScene::Update& moved) {
+	switch(edit.kind) {
+	case EditKind::MovePoint: {
+		if(edit.curve>=scene.curves.size() || edit.point>=scene.curves[edit.curve].Points().size()) {
+			return;
+		}
+		const CurveScene::Update update = scene.MovePoint(edit.curve,edit.point,edit.pos);
+		CurveScene::Slice lines{moved.lines.first,moved.lines.count};
+		CurveScene::Slice points{moved.points.first,moved.points.count};
+		unite(lines,update.lines.first,update.lines.count);
+		unite(points,update.points.first,update.points.count);
+		moved.lines = {lines.first,lines.count};
+		moved.points = {points.first,points.count};
+		return;
+	}
+	case EditKind::View:
+		scene.SetView(edit.view,edit.pixelsPerUnit);
+		return;
+	case EditKind::MinLinePoints:
+		scene.SetMinLinePoints(edit.minLinePoints);
+		return;
+	case EditKind::Curve:
+		break;
+	}
+	while(scene.curves.size()<=edit.curve) {
+		scene.AddCurve();
+		lastDrain.push_back(0);
+	}
+	if(lastDrain[edit.curve]==drain) {
+		superseded.fetch_add(1,std::memory_order_relaxed);
+	}
+	lastDrain[edit.curve] = drain;
+	BezierCurve& curve = scene.curves[edit.curve];
+	if(curve.Points().size()==edit.points.size()) {
+		for(size_t i=0;i<edit.points.size();i++) {
+			curve.SetPoint(i,edit.points[i]);
+		}
+	}else {
+		curve.ClearPoints();
+		curve.AddPoints(edit.points.data(),edit.points.size());
+	}
+	if(curve.GetPrecision()!=edit.precision) {
+		curve.SetPrecision(edit.precision);
+	}
+	curve.SetFlatnessTolerance(edit.flatnessTolerance);
+	curve.SetEvaluationMode(edit.evaluationMode);
+	curve.SetTessellationMode(edit.tessellationMode);
+	curve.SetScalarBackend(edit.scalarBackend);
+	scene.MarkDirty(edit.curve);
+}
+
+//the vectors of a slot keep their capacity, so steady state frames copy without allocating
+void TessellationThread::publish(const uint64_t edit) {
+	Frame& frame = frames[back];
+	//the slot was published two frames ago, its arrays are only copied again when they changed since, the vertices only where they did
+	if(frame.vertexRevision!=vertexRevision) {
+		const uint64_t old = frame.vertexRevision;
+		frame.vertexChanges.assign(vertexChanges.begin(),vertexChanges.end());
+		frame.vertexRevision = vertexRevision;
+		CurveScene::Slice range;
+		if(frame.vertices.size()==scene.Vertices().size() && frame.ChangesSince(old,range)) {
+			std::copy(scene.Vertices().begin()+range.first,scene.Vertices().begin()+range.first+range.count,frame.vertices.begin()+range.first);
+		}else {
+			frame.vertices.assign(scene.Vertices().begin(),scene.Vertices().end());
+		}
+	}
+	if(frame.pointRevision!=pointRevision) {
+		frame.controlPoints.assign(scene.ControlPoints().begin(),scene.ControlPoints().end());
+		frame.pointRevision = pointRevision;
+	}
+	frame.visibleLines.assign(scene.VisibleLines().begin(),scene.VisibleLines().end());
+	frame.pointCurves.clear();
+	for(const uint32_t i : scene.VisibleCurves()) {
+		const BezierCurve& curve = scene.curves[i];
+		if(scene.LineSlice(i).count>0 || curve.Points().size()<2) {
+			continue;
+		}
+		const size_t samples = CurveScene::LodCount(curve.SampleCount(),scene.Lod(i));
+		frame.pointCurves.push_back({static_cast<int32_t>(scene.PointSlice(i).first),static_cast<int32_t>(curve.Points().size()),static_cast<int32_t>(samples)});
+	}
+	frame.lineSlices.resize(scene.curves.size());
+	frame.lineRevisions.resize(scene.curves.size());
+	for(size_t i=0;i<scene.curves.size();i++) {
+		frame.lineSlices[i] = scene.LineSlice(i);
+		frame.lineRevisions[i] = scene.LineRevision(i);
+	}
+	frame.edit = edit;
+	frame.tessellationMicroseconds = scene.TessellationMicroseconds();
+	back = ready.exchange(back|freshBit,std::memory_order_acq_rel) & indexMask;
+	published.store(edit,std::memory_order_release);
+	framesPublished.fetch_add(1,std::memory_order_relaxed);
+	if(onFrame) {
+		onFrame();
+	}
+}
+
+void TessellationThread::workerLoop() {
+	while(true) {
+		sleeping.store(true,std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		{
+			std::unique_lock<std::mutex> lock(sleepMutex);
+			wake.wait(lock,[this] { return stop || queue.Front()!=nullptr; });
+			if(stop) {
+				sleeping.store(false,std::memory_order_relaxed);
+				return;
+			}
+		}
+		sleeping.store(false,std::memory_order_relaxed);
+		//what is queued now, at most a queue's worth so a producer that never pauses can't starve the tessellation
+		drain++;
+		uint64_t last = 0;
+		CurveScene::Update moved;
+		for(size_t i=0;i<queue.Capacity();i++) {
+			const Edit* edit = queue.Front();
+			if(!edit) {
+				break;
+			}
+			apply(*edit,moved);
+			last = edit->sequence;
+			queue.Pop();
+		}
+		scene.BeginTessellation(pool);
+		const CurveScene::Update update = scene.FinishTessellation(pool);
+		//a layout change moved the slices the moves were in, all of it counts as changed then
+		CurveScene::Slice lines{moved.lines.first,moved.lines.count};
+		unite(lines,update.lines.first,update.lines.count);
+		if(update.resized) {
+			lines = {0,scene.Vertices().size()};
+		}
+		if(update.resized || lines.count>0) {
+			vertexRevision++;
+			if(vertexChanges.size()==changeHistory) {
+				vertexChanges.erase(vertexChanges.begin());
+			}
+			vertexChanges.push_back({vertexRevision,lines});
+		}
+		if(update.resized || update.points.count>0 || moved.points.count>0) {
+			pointRevision++;
+		}
+		scene.Cull();
+		publish(last);
+	}
+}
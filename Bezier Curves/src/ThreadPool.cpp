@@ -0,0 +1,119 @@
+#include "../include/ThreadPool.h"
+
+ThreadPool::ThreadPool(unsigned threadCount) {
+	if(threadCount==0) {
+		const unsigned hardware = std::thread::hardware_concurrency();
+		threadCount = hardware>1 ? hardware-1 : 1;
+	}
+	for(unsigned i=0;i<threadCount;i++) {
+		workers.push_back(std::make_unique<Worker>());
+	}
+	for(unsigned i=0;i<threadCount;i++) {
+		threads.emplace_back(&ThreadPool::workerLoop,this,i);
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		stop = true;
+	}
+	wake.notify_all();
+	for(std::thread& thread : threads) {
+		thread.join();
+	}
+}
+
+void ThreadPool::Submit(Task task) {
+	Worker& worker = *workers[nextWorker];
+	nextWorker = (nextWorker+1)%workers.size();
+	unfinished++;
+	{
+		std::lock_guard<std::mutex> lock(worker.mutex);
+		worker.pushBack(std::move(task));
+	}
+	queued++;
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);//a worker between its check and its wait would miss the notify otherwise
+	}
+	wake.notify_one();
+}
+
+void ThreadPool::Worker::pushBack(Task task) {
+	if(count==tasks.size()) {
+		std::vector<Task> grown(tasks.empty() ? 64 : tasks.size()*2);
+		for(size_t i=0;i<count;i++) {
+			grown[i] = std::move(tasks[(head+i)%tasks.size()]);
+		}
+		tasks.swap(grown);
+		head = 0;
+	}
+	tasks[(head+count)%tasks.size()] = std::move(task);
+	count++;
+}
+
+ThreadPool::Task ThreadPool::Worker::popBack() {
+	count--;
+	return std::move(tasks[(head+count)%tasks.size()]);
+}
+
+ThreadPool::Task ThreadPool::Worker::popFront() {
+	Task task = std::move(tasks[head]);
+	head = (head+1)%tasks.size();
+	count--;
+	return task;
+}
+
+void ThreadPool::Wait() {
+	std::unique_lock<std::mutex> lock(sleepMutex);
+	done.wait(lock,[this] { return unfinished.load()==0; });
+}
+
+unsigned ThreadPool::ThreadCount() const {
+	return static_cast<unsigned>(threads.size());
+}
+
+//own queue is used as a stack, the newest task has the warmest cache
+bool ThreadPool::popOwn(const unsigned index, Task& task) {
+	Worker& worker = *workers[index];
+	std::lock_guard<std::mutex> lock(worker.mutex);
+	if(worker.count==0) {
+		return false;
+	}
+	task = worker.popBack();
+	queued--;
+	return true;
+}
+
+bool ThreadPool::steal(const unsigned index, Task& task) {
+	for(size_t i=1;i<workers.size();i++) {
+		Worker& victim = *workers[(index+i)%workers.size()];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if(victim.count==0) {
+			continue;
+		}
+		task = victim.popFront();
+		queued--;
+		return true;
+	}
+	return false;
+}
+
+void ThreadPool::workerLoop(const unsigned index) {
+	while(true) {
+		Task task;
+		if(popOwn(index,task) || steal(index,task)) {
+			task();
+			if(--unfinished==0) {
+				std::lock_guard<std::mutex> lock(sleepMutex);
+				done.notify_all();
+			}
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		wake.wait(lock,[this] { return stop || queued.load()>0; });
+		if(stop && queued.load()==0) {
+			return;
+		}
+	}
+}
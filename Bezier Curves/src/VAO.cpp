@@ -11,6 +11,12 @@ void VAO::addAttrib(GLuint id,/*VBO vbo, */GLuint layout, GLint size, GLenum typ
 	glVertexAttribPointer(layout, size, type, normalized, stride, offset);
 }
 
+void VAO::addIntAttrib(GLuint id, GLuint layout, GLint size, GLenum type, GLsizei stride, const void* offset) {
+	bind(id);
+	glEnableVertexAttribArray(layout);
+	glVertexAttribIPointer(layout, size, type, stride, offset);
+}
+
 void VAO::setAttribDivisor(GLuint id, GLuint index, GLuint divisor){
 	bind(id);
 	glVertexAttribDivisor(index, divisor);
@@ -0,0 +1,562 @@
+//accuracy of the evaluation modes, incremental moves, the arc length table and the curve queries against de Casteljau in double,
+//scene files, and steady state allocations, exits with 1 on a failure
+//usage: bezier_tests
+
+#include "../include/BezierCurve.h"
+#include "../include/BezierCurveN.h"
+#include "../include/BezierBatch.h"
+#include "../include/CompositeCurve.h"
+#include "../include/CountingResource.h"
+#include "../include/CurveQuery.h"
+#include "../include/CurveScene.h"
+#include "../include/SceneFile.h"
+#include "../include/ThreadPool.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+	int failures = 0;
+
+	void check(const bool ok, const std::string& what) {
+		if(!ok) {
+			std::cout << "FAIL " << what << std::endl;
+			failures++;
+		}
+	}
+
+	//zig-zag control polygon in the 800x600 window like the benchmark's
+	void fillCurve(BezierCurve& curve, const size_t count) {
+		curve.ClearPoints();
+		for(size_t i=0;i<count;i++) {
+			const float x = 20.0f+760.0f*static_cast<float>(i)/static_cast<float>(count>1 ? count-1 : 1);
+			const float y = 300.0f+250.0f*((i*7919)%17/8.0f-1.0f);
+			curve.AddPoint({x,y});
+		}
+	}
+
+	//whichever mode the curve falls back to, its samples have to stay within a fraction of a pixel
+	void testForwardDifferences() {
+		const float maxError = 0.01f;
+		for(size_t count=2;count<=24;count++) {
+			for(const float precision : {0.1f,0.01f,0.001f,1e-4f,1e-5f}) {
+				BezierCurve curve;
+				fillCurve(curve,count);
+				curve.SetPrecision(precision);
+				curve.SetEvaluationMode(BezierCurve::EvaluationMode::ForwardDifference);
+				const float error = curve.MaxError(BezierCurve::ScalarBackend::Float);
+				const bool forward = curve.EffectiveEvaluationMode()==BezierCurve::EvaluationMode::ForwardDifference;
+				check(error<=maxError,"forward differences, "+std::to_string(count)+" points, precision "+std::to_string(precision)
+					+(forward ? "" : " (Bernstein)")+": error "+std::to_string(error));
+			}
+		}
+		//low degrees at the default precision must not fall back
+		for(size_t count=2;count<=6;count++) {
+			BezierCurve curve;
+			fillCurve(curve,count);
+			curve.SetEvaluationMode(BezierCurve::EvaluationMode::ForwardDifference);
+			check(curve.EffectiveEvaluationMode()==BezierCurve::EvaluationMode::ForwardDifference,
+				"forward differences used for "+std::to_string(count)+" points");
+		}
+	}
+
+	glm::dvec2 referencePoint(const std::vector<glm::vec2>& points, const double t) {
+		std::vector<glm::dvec2> p(points.begin(),points.end());
+		for(size_t k=p.size()-1;k>0;k--) {
+			for(size_t i=0;i<k;i++) {
+				p[i] = p[i]*(1.0-t)+p[i+1]*t;
+			}
+		}
+		return p[0];
+	}
+	//length from 0 to t in double with chords fine enough that their error is far below the tolerance
+	double referenceLength(const std::vector<glm::vec2>& points, const double t) {
+		const size_t steps = 1<<16;
+		double length = 0.0;
+		glm::dvec2 last = referencePoint(points,0.0);
+		for(size_t i=1;i<=steps;i++) {
+			const glm::dvec2 p = referencePoint(points,t*static_cast<double>(i)/steps);
+			length += glm::length(p-last);
+			last = p;
+		}
+		return length;
+	}
+
+	//the table's lengths, and the lengths at the t it returns, within arcLengthTolerance pixels of the arc
+	void testArcLength() {
+		const double maxError = BezierCurve::arcLengthTolerance;
+		for(const size_t count : {2,3,4,5,6,8,12,16,24}) {
+			BezierCurve curve;
+			fillCurve(curve,count);
+			const std::vector<glm::vec2> points(curve.Points().begin(),curve.Points().end());
+			const double length = referenceLength(points,1.0);
+			const double error = std::abs(curve.Length()-length);
+			check(error<=maxError,"arc length, "+std::to_string(count)+" points: error "+std::to_string(error));
+			for(const double fraction : {0.1,0.37,0.5,0.81}) {
+				const float t = curve.TAtLength(static_cast<float>(length*fraction));
+				const double tError = std::abs(referenceLength(points,t)-length*fraction);
+				check(tError<=maxError,"t at arc length, "+std::to_string(count)+" points, "+std::to_string(fraction)+" of it: error "+std::to_string(tError));
+			}
+		}
+	}
+
+	//forward differences of the fixed degree curve within forwardDifferenceTolerance on every instruction set the cpu has,
+	//the float degrees up to BezierBatch::maxStepRows-1 step in BezierBatch and the rest, like double points, in the header
+	template<size_t Degree, class Vec>
+	void testFixedDegree() {
+		using Curve = BezierCurveN<Degree,Vec>;
+		std::array<Vec,Degree+1> points;
+		std::vector<glm::vec2> reference;
+		for(size_t i=0;i<=Degree;i++) {
+			const float x = 20.0f+760.0f*static_cast<float>(i)/static_cast<float>(Degree);
+			const float y = 300.0f+250.0f*((i*7919)%17/8.0f-1.0f);
+			points[i] = Vec(x,y);
+			reference.push_back({x,y});
+		}
+		Curve curve(points);
+		const BezierBatch::InstructionSet active = BezierBatch::Active();
+		for(int set=0;set<=static_cast<int>(BezierBatch::Detect());set++) {
+			BezierBatch::SetActive(static_cast<BezierBatch::InstructionSet>(set));
+			for(const float precision : {0.1f,0.01f,0.001f,1e-4f}) {
+				curve.SetPrecision(precision);
+				std::vector<Vec> line(curve.SampleCount());
+				curve.RecalculateLine(line.data());
+				double error = 0.0;
+				for(size_t i=0;i<line.size();i++) {
+					const glm::dvec2 d = glm::dvec2(line[i].x,line[i].y)-referencePoint(reference,static_cast<double>(i)/static_cast<double>(line.size()-1));
+					error = std::max(error,std::sqrt(d.x*d.x+d.y*d.y));
+				}
+				check(error<=Curve::forwardDifferenceTolerance,"fixed degree "+std::to_string(Degree)+", "+BezierBatch::Name(BezierBatch::Active())
+					+", precision "+std::to_string(precision)+": error "+std::to_string(error));
+			}
+		}
+		BezierBatch::SetActive(active);
+	}
+
+	//samples that differ from before a move have to lie in the range it returned
+	template<class Line>
+	bool changedInside(const std::vector<glm::vec2>& before, const Line& after, const BezierCurve::DirtyRange range) {
+		for(size_t i=0;i<after.size();i++) {
+			if(after[i]!=before[i] && (i<range.first || i>=range.first+range.count)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	template<class Line>
+	float maxDistance(const Line& a, const Line& b) {
+		float distance = 0.0f;
+		for(size_t i=0;i<a.size();i++) {
+			distance = std::max(distance,glm::length(a[i]-b[i]));
+		}
+		return distance;
+	}
+
+	//drags at various points, many times maxIncrementalMoves in a row, against a curve recalculated from scratch
+	//points jump across the window so rounding piles up, without the periodic recalculation the drift gets past maxError
+	void testIncrementalMoves() {
+		const float maxError = 0.01f;
+		const size_t moves = 8*BezierCurve::maxIncrementalMoves;
+		for(const size_t count : {3,4,8,16}) {
+			BezierCurve curve;
+			fillCurve(curve,count);
+			curve.SetPrecision(0.001f);
+			curve.RecalculateLine();
+			BezierCurve reference;
+			fillCurve(reference,count);
+			reference.SetPrecision(0.001f);
+			std::vector<glm::vec2> before;
+			float error = 0.0f;
+			size_t incremental = 0;
+			bool inside = true;
+			for(size_t i=0;i<moves;i++) {
+				const size_t index = (i*7)%count;
+				const glm::vec2 pos(static_cast<float>(20+(i*7919)%760),static_cast<float>(50+(i*104729)%500));
+				before.assign(curve.linePoints.begin(),curve.linePoints.end());
+				const BezierCurve::DirtyRange range = curve.MovePoint(index,pos);
+				inside = inside && changedInside(before,curve.linePoints,range);
+				incremental += range.count<curve.linePoints.size() ? 1 : 0;
+				reference.SetPoint(index,pos);
+				reference.RecalculateLine();
+				error = std::max(error,maxDistance(curve.linePoints,reference.linePoints));
+			}
+			const std::string what = "incremental moves, "+std::to_string(count)+" points";
+			check(inside,what+": samples changed outside the dirty range");
+			check(error<=maxError,what+": drift "+std::to_string(error));
+			check(incremental>0,what+": no move was incremental");
+		}
+		//segments are re-tessellated from scratch, but only the ones in the range may change
+		for(const size_t count : {2,4,7,13}) {
+			CompositeCurve curve;
+			CompositeCurve reference;
+			for(size_t i=0;i<count;i++) {
+				const glm::vec2 p(20.0f+760.0f*static_cast<float>(i)/static_cast<float>(count-1),300.0f+250.0f*((i*7919)%17/8.0f-1.0f));
+				curve.points.push_back(p);
+				reference.points.push_back(p);
+			}
+			curve.SetPrecision(0.01f);
+			reference.SetPrecision(0.01f);
+			curve.RecalculateLine();
+			std::vector<glm::vec2> before;
+			float error = 0.0f;
+			bool inside = true;
+			for(size_t i=0;i<moves;i++) {
+				const size_t index = (i*7)%count;
+				const glm::vec2 pos(static_cast<float>(20+(i*7919)%760),static_cast<float>(50+(i*104729)%500));
+				before.assign(curve.linePoints.begin(),curve.linePoints.end());
+				inside = inside && changedInside(before,curve.linePoints,curve.MovePoint(index,pos));
+				reference.points[index] = pos;
+				reference.RecalculateLine();
+				error = std::max(error,maxDistance(curve.linePoints,reference.linePoints));
+			}
+			const std::string what = "composite moves, "+std::to_string(count)+" points";
+			check(inside,what+": samples changed outside the dirty range");
+			check(error<=maxError,what+": error "+std::to_string(error));
+		}
+	}
+
+	//nearest of dense samples, then narrowed down between the sample's neighbours by ternary search
+	double referenceClosest(const std::vector<glm::vec2>& points, const glm::dvec2 q, double& t) {
+		const size_t samples = 4096;
+		const auto distance = [&](const double u) { return glm::length(referencePoint(points,u)-q); };
+		size_t best = 0;
+		double bestDistance = std::numeric_limits<double>::infinity();
+		for(size_t i=0;i<=samples;i++) {
+			const double d = distance(static_cast<double>(i)/samples);
+			if(d<bestDistance) {
+				best = i;
+				bestDistance = d;
+			}
+		}
+		double lo = static_cast<double>(best>0 ? best-1 : 0)/samples;
+		double hi = static_cast<double>(std::min(best+1,samples))/samples;
+		for(int i=0;i<60;i++) {
+			const double a = lo+(hi-lo)/3.0;
+			const double b = hi-(hi-lo)/3.0;
+			if(distance(a)<distance(b)) {
+				hi = b;
+			}else {
+				lo = a;
+			}
+		}
+		t = (lo+hi)*0.5;
+		return std::min(distance(t),bestDistance);
+	}
+
+	//the distance within Tolerance() of the reference, and the point at the returned t as close to the query as the reference's,
+	//a t far from the reference's is fine as long as its point is as near, queries can be equally far from two parts of a curve
+	void testClosestPoints() {
+		ThreadPool pool;
+		CurveQuery query;
+		const double tolerance = query.Tolerance();
+		std::vector<std::vector<glm::vec2>> curves;
+		for(const size_t count : {2,3,4,6,9}) {
+			BezierCurve curve;
+			fillCurve(curve,count);
+			curves.emplace_back(curve.Points().begin(),curve.Points().end());
+			query.AddCurve(curves.back().data(),count);
+		}
+		//more than one batch so the pool splits it
+		const size_t n = 2*CurveQuery::batchSize+100;
+		std::vector<uint32_t> indices(n);
+		std::vector<glm::vec2> points(n);
+		for(size_t i=0;i<n;i++) {
+			indices[i] = static_cast<uint32_t>(i%curves.size());
+			points[i] = {static_cast<float>((i*7919)%800),static_cast<float>((i*104729)%600)};
+		}
+		CurveQuery::ClosestPointResults results;
+		query.ClosestPoints(indices.data(),points.data(),n,results,&pool);
+		for(size_t i=0;i<n;i++) {
+			const std::vector<glm::vec2>& curve = curves[indices[i]];
+			const glm::dvec2 q(points[i].x,points[i].y);
+			double t;
+			const double distance = referenceClosest(curve,q,t);
+			const glm::dvec2 atT = referencePoint(curve,results.t[i]);
+			const std::string what = "closest point, curve "+std::to_string(indices[i])+", query "+std::to_string(i);
+			check(std::abs(results.distance[i]-distance)<=tolerance,what+": distance "+std::to_string(results.distance[i])+" instead of "+std::to_string(distance));
+			check(glm::length(atT-q)-distance<=tolerance,what+": t "+std::to_string(results.t[i])+" instead of "+std::to_string(t));
+			check(glm::length(atT-glm::dvec2(results.x[i],results.y[i]))<=tolerance,what+": point isn't the curve's at t");
+		}
+		const uint32_t outOfRange = static_cast<uint32_t>(curves.size());
+		query.ClosestPoints(&outOfRange,points.data(),1,results);
+		check(std::isinf(results.distance[0]),"closest point on a curve that doesn't exist: distance "+std::to_string(results.distance[0]));
+	}
+
+	//each expected hit found once, at the expected point and at t on both curves whose points are within Tolerance() of it
+	void testIntersections() {
+		struct Pair {
+			const char* name;
+			std::vector<glm::vec2> a;
+			std::vector<glm::vec2> b;
+			std::vector<glm::dvec2> hits;
+		};
+		//the cubic's x is 300t and it meets the line y=-0.75(x-150) where (1-2t)(600t(1-t)-112.5)=0, at t 0.25, 0.5 and 0.75
+		const std::vector<Pair> pairs = {
+			{"crossing lines",{{0.0f,0.0f},{100.0f,100.0f}},{{0.0f,100.0f},{100.0f,0.0f}},{{50.0,50.0}}},
+			{"cubic and line",{{0.0f,0.0f},{100.0f,200.0f},{200.0f,-200.0f},{300.0f,0.0f}},{{-10.0f,120.0f},{310.0f,-120.0f}},{{75.0,56.25},{150.0,0.0},{225.0,-56.25}}},
+			{"disjoint",{{0.0f,0.0f},{100.0f,200.0f},{200.0f,-200.0f},{300.0f,0.0f}},{{0.0f,300.0f},{150.0f,400.0f},{300.0f,300.0f}},{}},
+		};
+		CurveQuery query;
+		const double tolerance = query.Tolerance();
+		std::vector<uint32_t> curvesA;
+		std::vector<uint32_t> curvesB;
+		for(const Pair& pair : pairs) {
+			curvesA.push_back(static_cast<uint32_t>(query.AddCurve(pair.a.data(),pair.a.size())));
+			curvesB.push_back(static_cast<uint32_t>(query.AddCurve(pair.b.data(),pair.b.size())));
+		}
+		//a curve with itself, and with one that doesn't exist
+		curvesA.push_back(curvesA[1]);
+		curvesB.push_back(curvesA[1]);
+		curvesA.push_back(curvesA[1]);
+		curvesB.push_back(static_cast<uint32_t>(query.CurveCount()));
+		CurveQuery::IntersectionResults results;
+		query.Intersect(curvesA.data(),curvesB.data(),curvesA.size(),results);
+		for(size_t i=0;i<pairs.size();i++) {
+			const Pair& pair = pairs[i];
+			const std::string what = std::string("intersections, ")+pair.name;
+			check(results.count[i]==pair.hits.size(),what+": "+std::to_string(results.count[i])+" hits instead of "+std::to_string(pair.hits.size()));
+			if(results.count[i]!=pair.hits.size()) {
+				continue;
+			}
+			for(size_t h=0;h<pair.hits.size();h++) {
+				const size_t hit = results.first[i]+h;
+				const glm::dvec2 expected = pair.hits[h];
+				check(glm::length(glm::dvec2(results.x[hit],results.y[hit])-expected)<=tolerance,what+", hit "+std::to_string(h)+": wrong point");
+				check(glm::length(referencePoint(pair.a,results.tA[hit])-expected)<=tolerance,what+", hit "+std::to_string(h)+": wrong t on the first curve");
+				check(glm::length(referencePoint(pair.b,results.tB[hit])-expected)<=tolerance,what+", hit "+std::to_string(h)+": wrong t on the second curve");
+			}
+		}
+		check(results.count[pairs.size()]==0,"intersections of a curve with itself: "+std::to_string(results.count[pairs.size()])+" hits");
+		check(results.count[pairs.size()+1]==0,"intersections with a curve that doesn't exist: "+std::to_string(results.count[pairs.size()+1])+" hits");
+	}
+
+	//scene files are written next to the test and removed again
+	const char* const scenePath = "bezier_tests_scene.bin";
+	const char* const corruptPath = "bezier_tests_corrupt.bin";
+
+	std::string readBytes(const char* path) {
+		std::ifstream in(path,std::ios::binary);
+		return std::string((std::istreambuf_iterator<char>(in)),std::istreambuf_iterator<char>());
+	}
+
+	void writeBytes(const char* path, const std::string& bytes) {
+		std::ofstream out(path,std::ios::binary | std::ios::trunc);
+		out.write(bytes.data(),static_cast<std::streamsize>(bytes.size()));
+	}
+
+	//a scene back from the file the way it was written, curves added whole, streamed and empty
+	void testSceneRoundTrip() {
+		std::vector<std::vector<glm::vec2>> curves;
+		for(const size_t count : {2,4,0,7,100}) {
+			std::vector<glm::vec2> points(count);
+			for(size_t i=0;i<count;i++) {
+				points[i] = {static_cast<float>(i)*1.5f,static_cast<float>((i*7919)%600)-0.25f};
+			}
+			curves.push_back(points);
+		}
+		{
+			SceneWriter writer(scenePath);
+			for(size_t c=0;c<curves.size();c++) {
+				const float precision = 0.01f*static_cast<float>(c+1);
+				if(c%2==0) {
+					writer.AddCurve(curves[c].data(),curves[c].size(),precision);
+					continue;
+				}
+				writer.BeginCurve(precision);
+				for(const glm::vec2& p : curves[c]) {
+					writer.AddPoint(p);
+				}
+				writer.EndCurve();
+			}
+			check(writer.Finish(),"scene round trip: writing failed");
+		}
+		SceneFile scene(scenePath);
+		check(scene.IsOpen(),"scene round trip: "+scene.Error());
+		if(!scene.IsOpen()) {
+			return;
+		}
+		check(scene.CurveCount()==curves.size(),"scene round trip: "+std::to_string(scene.CurveCount())+" curves");
+		size_t pointCount = 0;
+		for(size_t c=0;c<curves.size() && c<scene.CurveCount();c++) {
+			const SceneFile::Curve curve = scene.CurveAt(c);
+			pointCount += curves[c].size();
+			check(curve.count==curves[c].size() && std::equal(curves[c].begin(),curves[c].end(),curve.points),"scene round trip: points of curve "+std::to_string(c));
+			check(curve.precision==0.01f*static_cast<float>(c+1),"scene round trip: precision of curve "+std::to_string(c));
+			check(reinterpret_cast<uintptr_t>(curve.points)%alignof(glm::vec2)==0,"scene round trip: curve "+std::to_string(c)+" isn't aligned");
+		}
+		check(scene.PointCount()==pointCount,"scene round trip: "+std::to_string(scene.PointCount())+" points");
+	}
+
+	//every damage to the file written by testSceneRoundTrip has to be caught by Open, with the reason in Error
+	void testSceneValidation() {
+		const std::string bytes = readBytes(scenePath);
+		SceneFormat::Header header;
+		std::memcpy(&header,bytes.data(),sizeof(header));
+		const auto patched = [&](const size_t offset, const auto value) {
+			std::string patch = bytes;
+			std::memcpy(&patch[offset],&value,sizeof(value));
+			return patch;
+		};
+		struct Damage {
+			const char* name;
+			std::string bytes;
+			const char* error;
+		};
+		const std::vector<Damage> damages = {
+			{"smaller than the header",bytes.substr(0,sizeof(header)/2),"too small"},
+			{"truncated",bytes.substr(0,bytes.size()-8),"truncated"},
+			{"grown",bytes+std::string(64,'\0'),"truncated"},
+			{"wrong magic",patched(0,'X'),"not a scene file"},
+			{"other byte order",patched(offsetof(SceneFormat::Header,byteOrder),uint32_t(0x04030201)),"byte order"},
+			{"newer version",patched(offsetof(SceneFormat::Header,version),SceneFormat::version+1),"unsupported version"},
+			{"points past the index",patched(offsetof(SceneFormat::Header,pointCount),header.pointCount+8),"sections out of bounds"},
+			{"unaligned index",patched(offsetof(SceneFormat::Header,indexOffset),header.indexOffset-8),"sections out of bounds"},
+			{"curves past the end",patched(offsetof(SceneFormat::Header,curveCount),header.curveCount+1),"sections out of bounds"},
+			{"curve past the points",patched(header.indexOffset+offsetof(SceneFormat::CurveEntry,pointCount),static_cast<uint32_t>(header.pointCount+1)),"curve 0 out of bounds"},
+			{"curve starting past the points",patched(header.indexOffset+offsetof(SceneFormat::CurveEntry,firstPoint),header.pointCount+1),"curve 0 out of bounds"},
+		};
+		for(const Damage& damage : damages) {
+			writeBytes(corruptPath,damage.bytes);
+			SceneFile scene(corruptPath);
+			check(!scene.IsOpen() && scene.Error().find(damage.error)!=std::string::npos,std::string("scene validation, ")+damage.name+": "
+				+(scene.IsOpen() ? "opened" : scene.Error()));
+			check(scene.CurveCount()==0 && scene.Points()==nullptr,std::string("scene validation, ")+damage.name+": left open");
+		}
+		//too many points for one curve are rejected before anything is read, so the data isn't needed
+		const glm::vec2 point(0.0f);
+		{
+			SceneWriter writer(corruptPath);
+			writer.AddCurve(&point,1);
+			writer.BeginCurve();
+			writer.AddPoints(&point,1);
+			writer.AddPoints(nullptr,static_cast<size_t>(SceneFormat::maxCurvePoints));
+			check(!writer.Finish(),"scene writer: a curve of more than maxCurvePoints points was written");
+		}
+		SceneFile scene(corruptPath);
+		check(!scene.IsOpen(),"scene writer: the file of a failed scene opens");
+		std::remove(corruptPath);
+		std::remove(scenePath);
+	}
+
+	//every path command, absolute and relative, with the number syntax the importer has to split by itself
+	void testSvgImport() {
+		std::istringstream svg(
+			"<svg xmlns=\"http://www.w3.org/2000/svg\">\n"
+			"<path id=\"a\" d=\"M10 20 L30 40 h10 v-5 C 1 2 3 4 5 6 s 1 1 2 2 Q0 0 1 1 T 4 4 z\"/>\n"
+			"<path id=\"no-data\"/>\n"
+			"<path d='m0,0 l1.5.5-2-3 A 5 5 0 0 1 10 10'/>\n"
+			"</svg>\n");
+		const std::vector<std::vector<glm::vec2>> expected = {
+			{{10,20},{30,40}},
+			{{30,40},{40,40}},
+			{{40,40},{40,35}},
+			{{40,35},{1,2},{3,4},{5,6}},
+			//s reflects the last control point of C around the current point
+			{{5,6},{7,8},{6,7},{7,8}},
+			{{7,8},{0,0},{1,1}},
+			{{1,1},{2,2},{4,4}},
+			{{4,4},{10,20}},
+			{{0,0},{1.5f,0.5f}},
+			{{1.5f,0.5f},{-0.5f,-2.5f}},
+			//arcs become lines
+			{{-0.5f,-2.5f},{10,10}},
+		};
+		size_t imported = 0;
+		{
+			SceneWriter writer(scenePath);
+			imported = SceneImport::Svg(svg,writer,0.02f);
+			check(writer.Finish(),"svg import: writing failed");
+		}
+		check(imported==expected.size(),"svg import: "+std::to_string(imported)+" curves instead of "+std::to_string(expected.size()));
+		SceneFile scene(scenePath);
+		check(scene.IsOpen() && scene.CurveCount()==expected.size(),"svg import: "+scene.Error());
+		for(size_t c=0;c<expected.size() && c<scene.CurveCount();c++) {
+			const SceneFile::Curve curve = scene.CurveAt(c);
+			check(curve.count==expected[c].size() && std::equal(expected[c].begin(),expected[c].end(),curve.points),"svg import: points of curve "+std::to_string(c));
+			check(curve.precision==0.02f,"svg import: precision of curve "+std::to_string(c));
+		}
+		scene.Close();
+		std::remove(scenePath);
+	}
+
+	//dragging and zooming back and forth, once every buffer has grown neither the scene nor a curve of its own may allocate
+	void testSteadyStateAllocations() {
+		ThreadPool pool;
+		CountingResource counting;
+		CurveScene scene(&counting);
+		for(size_t i=0;i<20;i++) {
+			fillCurve(scene.curves[scene.AddCurve()],4+i%12);
+		}
+		BezierCurve curve(&counting);
+		fillCurve(curve,24);
+		size_t frame = 0;
+		const auto edit = [&] {
+			const size_t c = frame%scene.curves.size();
+			const glm::vec2 offset((frame++%2) ? 1.0f : -1.0f,0.0f);
+			scene.MovePoint(c,1,scene.curves[c].Points()[1]+offset);
+			curve.MovePoint(1,curve.Points()[1]+offset);
+			for(const float precision : {0.005f,0.01f}) {
+				for(BezierCurve& sceneCurve : scene.curves) {
+					sceneCurve.SetPrecision(precision);
+				}
+				scene.MarkAllDirty();
+				scene.BeginTessellation(pool);
+				scene.FinishTessellation(pool);
+				curve.SetPrecision(precision);
+				curve.RecalculateLine();
+			}
+		};
+		//every curve is moved once at both precisions before counting, which builds its caches
+		scene.BeginTessellation(pool);
+		scene.FinishTessellation(pool);
+		for(size_t i=0;i<scene.curves.size();i++) {
+			edit();
+		}
+		counting.Reset();
+		for(size_t i=0;i<4*scene.curves.size();i++) {
+			edit();
+		}
+		check(counting.Allocations()==0,"steady state drag and zoom: "+std::to_string(counting.Allocations())+" allocations, "
+			+std::to_string(counting.BytesAllocated())+" bytes");
+	}
+}
+
+int main() {
+	testForwardDifferences();
+	testIncrementalMoves();
+	testArcLength();
+	testFixedDegree<1,glm::vec2>();
+	testFixedDegree<2,glm::vec2>();
+	testFixedDegree<3,glm::vec2>();
+	testFixedDegree<4,glm::vec2>();
+	testFixedDegree<5,glm::vec2>();
+	testFixedDegree<7,glm::vec2>();
+	testFixedDegree<9,glm::vec2>();
+	testFixedDegree<3,glm::dvec2>();
+	testClosestPoints();
+	testIntersections();
+	testSceneRoundTrip();
+	testSceneValidation();
+	testSvgImport();
+	testSteadyStateAllocations();
+	if(failures>0) {
+		std::cout << failures << " checks failed" << std::endl;
+		return 1;
+	}
+	std::cout << "All checks passed" << std::endl;
+	return 0;
+}
@@ -0,0 +1,56 @@
+//converts svg paths or text point lists into the binary scene format the application loads
+//usage: bezier_scene_convert input.svg|input.txt output.bzs [precision]
+
+#include "../include/SceneFile.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+namespace {
+	bool endsWith(const std::string& text, const std::string& suffix) {
+		return text.size()>=suffix.size() && text.compare(text.size()-suffix.size(),suffix.size(),suffix)==0;
+	}
+}
+
+int main(int argc, char** argv) {
+	if(argc<3) {
+		std::cout << "usage: bezier_scene_convert input.svg|input.txt output.bzs [precision]" << std::endl;
+		return 1;
+	}
+	const std::string input = argv[1];
+	const std::string output = argv[2];
+	const float precision = argc>3 ? static_cast<float>(std::atof(argv[3])) : 0.01f;
+	if(!(precision>0.0f && precision<=1.0f)) {
+		std::cout << "precision has to be in (0,1]" << std::endl;
+		return 1;
+	}
+	std::ifstream in(input, std::ios::binary);
+	if(!in) {
+		std::cout << "can't open " << input << std::endl;
+		return 1;
+	}
+	SceneWriter writer;
+	if(!writer.Open(output)) {
+		std::cout << "can't write " << output << std::endl;
+		return 1;
+	}
+	const auto start = std::chrono::steady_clock::now();
+	const size_t curves = endsWith(input,".svg") ? SceneImport::Svg(in,writer,precision) : SceneImport::Text(in,writer,precision);
+	if(!writer.Finish()) {
+		std::cout << "writing " << output << " failed" << std::endl;
+		return 1;
+	}
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+
+	//read back through the loader, so a file that was written is known to load
+	SceneFile scene(output);
+	if(!scene.IsOpen()) {
+		std::cout << scene.Error() << std::endl;
+		return 1;
+	}
+	std::cout << input << " -> " << output << ": " << curves << " curves, " << scene.PointCount() << " control points in " << seconds*1000.0 << " ms" << std::endl;
+	return 0;
+}